@@ -0,0 +1,40 @@
+// Converts HDF5 nuclides from CHARMANDER_CROSS_SECTIONS into binary caches
+// that Nuclide maps in place. Point CHARMANDER_XS_CACHE at the output
+// directory to have Nuclide::LoadFromFile pick them up.
+//
+//   charmander_xs_cache <output_dir> <nuclide> [<nuclide> ...]
+
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "materials/nuclide.h"
+#include "materials/xs_cache.h"
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0] << " <output_dir> <nuclide> [<nuclide> ...]"
+              << std::endl;
+    return 1;
+  }
+
+  std::filesystem::path output_dir(argv[1]);
+  try {
+    std::filesystem::create_directories(output_dir);
+    for (int i = 2; i < argc; ++i) {
+      charmander::Nuclide nuc(argv[i]);
+      // always convert from the HDF5 library, never from an older cache
+      nuc.LoadFromHDF5();
+      std::filesystem::path cache_file =
+          output_dir / charmander::XSCache::CacheFileName(
+                           nuc.GetName(), nuc.GetTemperature());
+      nuc.WriteXSCache(cache_file.string());
+      std::cout << nuc.GetName() << " -> " << cache_file.string() << std::endl;
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,14 @@
+# --------------------------------------------------------------------------- #
+# Setup host CPU tuning
+# --------------------------------------------------------------------------- #
+option(CHARMANDER_NATIVE_ARCH "Tune for the host CPU (enables AVX2/AVX-512 kernels)" OFF)
+
+if(CHARMANDER_NATIVE_ARCH)
+  if(CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+    add_compile_options(
+      -march=native
+    )
+  else()
+    message(FATAL_ERROR "Native arch tuning is only supported with GCC or Clang")
+  endif()
+endif()
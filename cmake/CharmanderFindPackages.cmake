@@ -1,4 +1,9 @@
 # --------------------------------------------------------------------------- #
 # HDF5
 # --------------------------------------------------------------------------- #
-find_package(HDF5 REQUIRED COMPONENTS HL)
\ No newline at end of file
+find_package(HDF5 REQUIRED COMPONENTS HL)
+
+# --------------------------------------------------------------------------- #
+# Threads
+# --------------------------------------------------------------------------- #
+find_package(Threads REQUIRED)
\ No newline at end of file
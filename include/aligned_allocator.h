@@ -0,0 +1,63 @@
+#ifndef CHARMANDER_ALIGNED_ALLOCATOR_H_
+#define CHARMANDER_ALIGNED_ALLOCATOR_H_
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include "constants.h"
+
+namespace charmander {
+
+// ----------------------------------------------------------------------------
+// AlignedAllocator
+// ----------------------------------------------------------------------------
+
+// std allocator that hands out Alignment-byte aligned blocks, so contiguous
+// data can start on a cache line or SIMD register boundary
+template <typename T, size_t Alignment = CACHE_LINE_BYTES>
+struct AlignedAllocator {
+  static_assert(Alignment >= alignof(T), "alignment weaker than the type's");
+  static_assert((Alignment & (Alignment - 1)) == 0,
+                "alignment must be a power of two");
+
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = AlignedAllocator<U, Alignment>;
+  };
+
+  AlignedAllocator() noexcept = default;
+
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(
+        ::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+  }
+
+  void deallocate(T* p, size_t) noexcept {
+    ::operator delete(p, std::align_val_t(Alignment));
+  }
+};
+
+template <typename T, typename U, size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment>&,
+                const AlignedAllocator<U, Alignment>&) {
+  return true;
+}
+
+template <typename T, typename U, size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment>&,
+                const AlignedAllocator<U, Alignment>&) {
+  return false;
+}
+
+template <typename T, size_t Alignment = CACHE_LINE_BYTES>
+using AlignedVector = std::vector<T, AlignedAllocator<T, Alignment>>;
+
+}  // namespace charmander
+
+#endif  // CHARMANDER_ALIGNED_ALLOCATOR_H_
@@ -33,6 +33,40 @@ struct Direction {
   Direction(Point p) : x(p.x), y(p.y), z(p.z) {}
 };
 
+// ----------------------------------------------------------------------------
+// Vec3
+// ----------------------------------------------------------------------------
+
+// assignable 3-vector for state that is updated in place. Point and
+// Direction convert in and back out explicitly
+struct Vec3 {
+  double x{0.0};
+  double y{0.0};
+  double z{0.0};
+
+  Vec3() = default;
+  Vec3(double _x, double _y, double _z) : x(_x), y(_y), z(_z) {}
+  explicit Vec3(const Point& p) : x(p.x), y(p.y), z(p.z) {}
+  explicit Vec3(const Direction& d) : x(d.x), y(d.y), z(d.z) {}
+
+  Point ToPoint() const { return Point(x, y, z); }
+  Direction ToDirection() const { return Direction(x, y, z); }
+
+  Vec3& operator+=(const Vec3& other) {
+    x += other.x;
+    y += other.y;
+    z += other.z;
+    return *this;
+  }
+
+  Vec3& operator*=(double a) {
+    x *= a;
+    y *= a;
+    z *= a;
+    return *this;
+  }
+};
+
 // ----------------------------------------------------------------------------
 // Helper operator overloads
 // ----------------------------------------------------------------------------
@@ -102,6 +136,30 @@ inline bool fuzzyequal(const Direction& a, const Direction& b) {
   return (a.x - b.x < FP_TOLERANCE) && (a.y - b.y < FP_TOLERANCE) && (a.z - b.z < FP_TOLERANCE);
 }
 
+inline bool operator==(const Vec3& a, const Vec3& b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+inline Vec3 operator+(const Vec3& a, const Vec3& b) {
+  return Vec3(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+inline Vec3 operator-(const Vec3& a, const Vec3& b) {
+  return Vec3(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+inline Vec3 operator*(double a, const Vec3& v) {
+  return Vec3(a * v.x, a * v.y, a * v.z);
+}
+
+inline double dot(const Vec3& a, const Vec3& b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const Vec3& v) {
+  return os << "Vec3(" << v.x << ", " << v.y << ", " << v.z << ")";
+}
+
 }  // namespace charmander
 
 #endif  // CHARMANDER_BASIC_TYPES_H_
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef CHARMANDER_CONSTANTS_H_
 #define CHARMANDER_CONSTANTS_H_
 
+#include <cstddef>
 #include <limits>
 
 namespace charmander
@@ -10,6 +11,15 @@ namespace charmander
   constexpr double FP_TOLERANCE = 1e-12;
 
   constexpr double COINCIDENT_SURF = 1e-12;
+
+  // how far past a crossed surface a particle is placed, so the next cell
+  // search sees the far side
+  constexpr double BOUNDARY_NUDGE = 1e-9;
+
+  constexpr size_t CACHE_LINE_BYTES = 64;
+
+  // upper limit on equal-lethargy buckets in a nuclide energy hash
+  constexpr size_t MAX_ENERGY_HASH_BINS = 8192;
 } // namespace charmander
 
 #endif  // CHARMANDER_CONSTANTS_H_
\ No newline at end of file
@@ -0,0 +1,69 @@
+#ifndef CHARMANDER_GEOMETRY_BOUNDING_BOX_H_
+#define CHARMANDER_GEOMETRY_BOUNDING_BOX_H_
+
+#include <algorithm>
+#include <cmath>
+
+#include "basic_types.h"
+#include "constants.h"
+#include "geometry/surface_table.h"
+
+namespace charmander {
+
+// axis aligned box, unbounded by default. closed, so points on a face are
+// inside
+struct BoundingBox {
+  double x_min{-INF};
+  double x_max{INF};
+  double y_min{-INF};
+  double y_max{INF};
+  double z_min{-INF};
+  double z_max{INF};
+
+  static BoundingBox Empty() { return {INF, -INF, INF, -INF, INF, -INF}; }
+
+  bool IsEmpty() const {
+    return x_min > x_max || y_min > y_max || z_min > z_max;
+  }
+
+  bool IsBounded() const {
+    return std::isfinite(x_min) && std::isfinite(x_max) &&
+           std::isfinite(y_min) && std::isfinite(y_max) &&
+           std::isfinite(z_min) && std::isfinite(z_max);
+  }
+
+  bool Contains(const Point& p) const {
+    return p.x >= x_min && p.x <= x_max && p.y >= y_min && p.y <= y_max &&
+           p.z >= z_min && p.z <= z_max;
+  }
+
+  // whether the ray p + t d meets the box for some t in [0, t_max]
+  bool Intersects(const Point& p, const Direction& d, double t_max = INF) const;
+
+  Point Center() const {
+    return Point(0.5 * (x_min + x_max), 0.5 * (y_min + y_max),
+                 0.5 * (z_min + z_max));
+  }
+};
+
+inline BoundingBox IntersectBoxes(const BoundingBox& a, const BoundingBox& b) {
+  return {std::max(a.x_min, b.x_min), std::min(a.x_max, b.x_max),
+          std::max(a.y_min, b.y_min), std::min(a.y_max, b.y_max),
+          std::max(a.z_min, b.z_min), std::min(a.z_max, b.z_max)};
+}
+
+inline BoundingBox UnionBoxes(const BoundingBox& a, const BoundingBox& b) {
+  if (a.IsEmpty()) return b;
+  if (b.IsEmpty()) return a;
+  return {std::min(a.x_min, b.x_min), std::max(a.x_max, b.x_max),
+          std::min(a.y_min, b.y_min), std::max(a.y_max, b.y_max),
+          std::min(a.z_min, b.z_min), std::max(a.z_max, b.z_max)};
+}
+
+// conservative box around one side of a packed surface. only planes normal
+// to an axis and the inside of cylinders bound anything
+BoundingBox HalfspaceBounds(const SurfaceData& surface, bool positive);
+
+}  // namespace charmander
+
+#endif  // CHARMANDER_GEOMETRY_BOUNDING_BOX_H_
@@ -16,8 +16,11 @@ class Cylinder : public Surface {
 
   double Distance(Point p, Direction d) const override;
 
+  SurfaceData Pack() const override;
+
  protected:
   double r_;
+  double r2_;
   Direction axis_;
   Point p0_;
 };
@@ -26,18 +29,51 @@ class XCylinder : public Cylinder {
  public:
   XCylinder(double r, Point center)
       : Cylinder(r, Direction(1.0, 0.0, 0.0), Point(0.0, center.y, center.z)) {}
+
+  // only touch the y and z coordinates
+  double Evaluate(Point p) const override;
+
+  Direction Normal(Point p) const override;
+
+  double Distance(Point p, Direction d) const override;
+
+  SurfaceData Pack() const override {
+    return {SurfaceType::X_CYLINDER, {r2_, p0_.y, p0_.z}};
+  }
 };
 
 class YCylinder : public Cylinder {
  public:
   YCylinder(double r, Point center)
       : Cylinder(r, Direction(0.0, 1.0, 0.0), Point(center.x, 0.0, center.z)) {}
+
+  // only touch the x and z coordinates
+  double Evaluate(Point p) const override;
+
+  Direction Normal(Point p) const override;
+
+  double Distance(Point p, Direction d) const override;
+
+  SurfaceData Pack() const override {
+    return {SurfaceType::Y_CYLINDER, {r2_, p0_.x, p0_.z}};
+  }
 };
 
 class ZCylinder : public Cylinder {
  public:
   ZCylinder(double r, Point center)
       : Cylinder(r, Direction(0.0, 0.0, 1.0), Point(center.x, center.y, 0.0)) {}
+
+  // only touch the x and y coordinates
+  double Evaluate(Point p) const override;
+
+  Direction Normal(Point p) const override;
+
+  double Distance(Point p, Direction d) const override;
+
+  SurfaceData Pack() const override {
+    return {SurfaceType::Z_CYLINDER, {r2_, p0_.x, p0_.y}};
+  }
 };
 
 }  // namespace charmander
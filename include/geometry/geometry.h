@@ -1,13 +1,161 @@
 #ifndef CHARMANDER_GEOMETRY_GEOMETRY_H_
 #define CHARMANDER_GEOMETRY_GEOMETRY_H_
 
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "basic_types.h"
+#include "geometry/lattice.h"
+#include "geometry/neighbor_list.h"
+#include "geometry/region.h"
+#include "geometry/surface.h"
+#include "geometry/surface_table.h"
+#include "geometry/universe.h"
+
 namespace charmander {
 
+// one level of a point's position in the universe hierarchy
+struct GeometryLevel {
+  uint32_t cell;
+  // lattice and element this level's universe fills, or -1 at the root and
+  // for universe fills
+  int32_t lattice;
+  int32_t element;
+  // the point in this level's coordinates
+  Vec3 local;
+};
+
+// levels from the root universe down to the material cell
+struct GeometryLocation {
+  std::vector<GeometryLevel> levels;
+
+  uint32_t GetCell() const { return levels.back().cell; }
+
+  // the point in root coordinates
+  const Vec3& GetPosition() const { return levels.front().local; }
+
+  // moves the point within its cell, every level translates the same
+  void Move(const Vec3& d, double distance) {
+    for (GeometryLevel& level : levels) {
+      level.local.x += distance * d.x;
+      level.local.y += distance * d.y;
+      level.local.z += distance * d.z;
+    }
+  }
+};
+
+// next boundary along a ray over every level of a location
+struct GeometryCrossing {
+  // the surface is null when a lattice element edge is crossed
+  BoundaryCrossing boundary;
+  // level whose cell or lattice element is left
+  uint32_t level{0};
+};
+
+// cells grouped into universes, with universe 0 the root. cells can be
+// filled by a material, another universe in the same coordinates, or a
+// lattice whose elements are filled by universes in element coordinates.
+// every cell region indexes one shared surface table, so a surface bounding
+// several cells is stored once
 class Geometry {
  public:
+  static constexpr uint32_t ROOT_UNIVERSE = 0;
+
   Geometry();
+
+  uint32_t AddUniverse();
+
+  uint32_t AddLattice(Lattice lattice);
+
+  // index of the new material cell in the root universe
+  size_t AddCell(Region region, int material_id);
+
+  size_t AddCell(uint32_t universe, Region region, int material_id);
+
+  // cell in universe filled by universe or lattice fill_index
+  size_t AddFilledCell(uint32_t universe, Region region, FillType fill,
+                       uint32_t fill_index);
+
+  size_t GetNumCells() const { return cells_.size(); }
+
+  const Cell& GetCell(size_t i) const { return cells_[i]; }
+
+  size_t GetNumUniverses() const { return universes_.size(); }
+
+  const Universe& GetUniverse(size_t i) const { return universes_[i]; }
+
+  size_t GetNumLattices() const { return lattices_.size(); }
+
+  // every surface of every cell
+  const SurfaceTable& GetSurfaceTable() const { return *surfaces_; }
+
+  const Lattice& GetLattice(size_t i) const { return lattices_[i]; }
+
+  // checks fills and builds every universe's bvh, call once every cell is
+  // added
+  void Finalize();
+
+  bool IsFinalized() const { return finalized_; }
+
+  // material cell containing p, if any
+  std::optional<size_t> FindCell(const Point& p) const;
+
+  // every level down to the material cell containing p, nothing if p is
+  // outside the model or falls outside a lattice
+  std::optional<GeometryLocation> Locate(const Point& p) const;
+
+  // Locate into an existing location, reusing its storage. false if p is
+  // not in the model
+  bool Locate(const Point& p, GeometryLocation& location) const;
+
+  // distance along d to the nearest boundary of any level's cell or lattice
+  // element
+  double Distance(const GeometryLocation& location, const Direction& d) const {
+    return NextCrossing(location, d).boundary.distance;
+  }
+
+  // Distance plus what is crossed there. coincident boundaries report the
+  // outermost level
+  GeometryCrossing NextCrossing(const GeometryLocation& location,
+                                const Direction& d) const;
+
+  // moves location to p, just past crossing, in place. levels above the
+  // crossing are kept and the crossed level first tries the cells already
+  // seen past that side of the surface, so a full search is only needed the
+  // first time a surface is crossed into a new cell. false once p is outside
+  // the model
+  bool Cross(GeometryLocation& location, const GeometryCrossing& crossing,
+             const Point& p) const;
+
+  // cells found so far past surface on its sense side
+  std::vector<uint32_t> GetNeighbors(const Surface& surface, bool sense) const;
+
+  // bvh nodes of the root universe
+  size_t GetNumBVHNodes() const {
+    return universes_[ROOT_UNIVERSE].GetNumBVHNodes();
+  }
+
+ private:
+  // appends levels below location's last cell until a material cell,
+  // false if a fill holds no cell at the point
+  bool Descend(GeometryLocation& location) const;
+
+  NeighborList& GetNeighborList(uint32_t surface_index, bool sense) const {
+    return neighbors_[2 * surface_index + (sense ? 1 : 0)];
+  }
+
+  std::shared_ptr<SurfaceTable> surfaces_;
+  std::vector<Cell> cells_;
+  std::vector<Universe> universes_;
+  std::vector<Lattice> lattices_;
+  // neighbor lists of table surface i are 2 i for the negative side and
+  // 2 i + 1 for the positive side. they fill in during transport
+  mutable std::vector<NeighborList> neighbors_;
+  bool finalized_{false};
 };
 
 }  // namespace charmander
 
-#endif  // CHARMANDER_GEOMETRY_GEOMETRY_H
\ No newline at end of file
+#endif  // CHARMANDER_GEOMETRY_GEOMETRY_H_
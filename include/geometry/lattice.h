@@ -0,0 +1,72 @@
+#ifndef CHARMANDER_GEOMETRY_LATTICE_H_
+#define CHARMANDER_GEOMETRY_LATTICE_H_
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "basic_types.h"
+
+namespace charmander {
+
+enum class LatticeType : uint8_t {
+  RECTANGULAR,
+  HEXAGONAL,
+};
+
+// regular 2d array of universes, infinite along z. the element holding a
+// point is computed arithmetically, and each element's universe is searched
+// in coordinates relative to the element center, so one pin universe can
+// fill every element
+class Lattice {
+ public:
+  // nx by ny elements of pitch_x by pitch_y starting at (x0, y0), element
+  // (i, j) is filled by universes[j * nx + i]
+  static Lattice Rectangular(double x0, double y0, double pitch_x,
+                             double pitch_y, size_t nx, size_t ny,
+                             std::vector<uint32_t> universes);
+
+  // hexagons with flat sides facing +-x, n_rings rings around (x0, y0).
+  // element centers sit at x0 + pitch (q + r / 2), y0 + pitch sqrt(3) / 2 r
+  // for axial coordinates (q, r), filled by universes[(r + n_rings - 1) *
+  // (2 n_rings - 1) + q + n_rings - 1]. entries outside the rings are unused
+  static Lattice Hexagonal(double x0, double y0, double pitch, size_t n_rings,
+                           std::vector<uint32_t> universes);
+
+  LatticeType GetType() const { return type_; }
+
+  size_t GetNumElements() const { return universes_.size(); }
+
+  // element holding (x, y), nothing outside the lattice
+  std::optional<size_t> GetElement(double x, double y) const;
+
+  std::pair<double, double> GetCenter(size_t element) const;
+
+  uint32_t GetUniverse(size_t element) const { return universes_[element]; }
+
+  const std::vector<uint32_t>& GetUniverses() const { return universes_; }
+
+  // distance from p, relative to an element center, to that element's
+  // boundary along d
+  double ElementDistance(const Point& p, const Direction& d) const;
+
+ private:
+  Lattice(LatticeType type, double x0, double y0, double pitch_x,
+          double pitch_y, size_t nx, size_t ny,
+          std::vector<uint32_t> universes);
+
+  LatticeType type_;
+  double x0_;
+  double y0_;
+  double pitch_x_;
+  double pitch_y_;
+  // elements per row and rows, 2 n_rings - 1 each for hexagonal lattices
+  size_t nx_;
+  size_t ny_;
+  std::vector<uint32_t> universes_;
+};
+
+}  // namespace charmander
+
+#endif  // CHARMANDER_GEOMETRY_LATTICE_H_
@@ -0,0 +1,59 @@
+#ifndef CHARMANDER_GEOMETRY_NEIGHBOR_LIST_H_
+#define CHARMANDER_GEOMETRY_NEIGHBOR_LIST_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "constants.h"
+
+namespace charmander {
+
+// cells found on one side of a surface, filled in during transport and
+// shared by every thread. entries are written once and published through
+// the atomic size, so lookups take no lock and threads only contend when
+// adding. a full list stops growing, later cells fall back to a full search.
+// lists are cache line aligned, so an Add never invalidates the line another
+// thread is reading a neighbouring list from
+class alignas(CACHE_LINE_BYTES) NeighborList {
+ public:
+  static constexpr size_t CAPACITY = 16;
+
+  // first listed cell accepted by match
+  template <typename Match>
+  std::optional<uint32_t> Find(Match&& match) const {
+    const size_t n = size_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < n; ++i) {
+      if (match(cells_[i])) return cells_[i];
+    }
+    return std::nullopt;
+  }
+
+  void Add(uint32_t cell) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t n = size_.load(std::memory_order_relaxed);
+    if (n == CAPACITY || std::find(cells_, cells_ + n, cell) != cells_ + n) {
+      return;
+    }
+    cells_[n] = cell;
+    size_.store(n + 1, std::memory_order_release);
+  }
+
+  std::vector<uint32_t> GetCells() const {
+    return std::vector<uint32_t>(
+        cells_, cells_ + size_.load(std::memory_order_acquire));
+  }
+
+ private:
+  uint32_t cells_[CAPACITY];
+  std::atomic<size_t> size_{0};
+  std::mutex mutex_;
+};
+
+}  // namespace charmander
+
+#endif  // CHARMANDER_GEOMETRY_NEIGHBOR_LIST_H_
@@ -16,26 +16,57 @@ class Plane : public Surface {
 
   virtual double Distance(Point p, Direction d) const override;
 
+  virtual SurfaceData Pack() const override;
+
  protected:
   double a_;
   double b_;
   double c_;
   double d_;
+  // unit normal, computed once
+  Direction n_;
 };
 
 class XPlane : public Plane {
  public:
   XPlane(double x0) : Plane(1.0, 0.0, 0.0, x0) {};
+
+  // only touch the x coordinate
+  double Evaluate(Point p) const override;
+
+  Direction Normal(Point p) const override;
+
+  double Distance(Point p, Direction d) const override;
+
+  SurfaceData Pack() const override { return {SurfaceType::X_PLANE, {d_}}; }
 };
 
 class YPlane : public Plane {
  public:
   YPlane(double y0) : Plane(0.0, 1.0, 0.0, y0) {};
+
+  // only touch the y coordinate
+  double Evaluate(Point p) const override;
+
+  Direction Normal(Point p) const override;
+
+  double Distance(Point p, Direction d) const override;
+
+  SurfaceData Pack() const override { return {SurfaceType::Y_PLANE, {d_}}; }
 };
 
 class ZPlane : public Plane {
  public:
   ZPlane(double z0) : Plane(0.0, 0.0, 1.0, z0) {};
+
+  // only touch the z coordinate
+  double Evaluate(Point p) const override;
+
+  Direction Normal(Point p) const override;
+
+  double Distance(Point p, Direction d) const override;
+
+  SurfaceData Pack() const override { return {SurfaceType::Z_PLANE, {d_}}; }
 };
 
 }  // namespace charmander
@@ -1,12 +1,17 @@
 #ifndef CHARMANDER_GEOMETRY_REGION_H_
 #define CHARMANDER_GEOMETRY_REGION_H_
 
+#include <cstdint>
+#include <memory>
 #include <utility>
 #include <stdexcept>
 #include <vector>
 
 #include "basic_types.h"
+#include "constants.h"
+#include "geometry/bounding_box.h"
 #include "geometry/surface.h"
+#include "geometry/surface_table.h"
 
 namespace charmander
 {
@@ -23,6 +28,8 @@ namespace charmander
 
       const Surface& GetSurface() const {return *surface_;}
 
+      bool IsPositive() const {return positive_;}
+
       Halfspace operator~() const {return Halfspace(surface_, !positive_);}
 
     private:
@@ -30,19 +37,165 @@ namespace charmander
       bool positive_;
   };
 
+  // where a ray first changes containment. surface is the surface crossed,
+  // null when nothing is crossed, surface_index its entry in the region's
+  // surface table and sense its side past the crossing
+  struct BoundaryCrossing
+  {
+    double distance{INF};
+    const Surface* surface{nullptr};
+    uint32_t surface_index{0};
+    bool sense{false};
+  };
+
   class Region
   {
   public:
     Region(std::vector<std::vector<Halfspace>> clauses);
   
-    const std::vector<std::vector<Halfspace>>& GetClauses() const {return clauses_;}
+    // rebuilt from the flat storage
+    std::vector<std::vector<Halfspace>> GetClauses() const;
+
+    size_t GetNumClauses() const {return clause_offsets_.size() - 1;}
+
+    bool Contains(const Point& p) const;
+
+    // distance along d to the first point where containment changes. senses
+    // are evaluated once and crossings are walked in order, flipping one
+    // surface's sense at a time
+    double Distance(const Point& p, const Direction& d) const {
+      return NextCrossing(p, d).distance;
+    }
+
+    // Distance plus the surface crossed there
+    BoundaryCrossing NextCrossing(const Point& p, const Direction& d) const;
+
+    // table the halfspaces index into. a region starts with a table of its
+    // own and shares its Geometry's once added as a cell
+    const SurfaceTable& GetSurfaceTable() const {return *surfaces_;}
+
+    // moves the halfspaces onto table, adding any surface it lacks, so
+    // regions sharing a table store each surface once
+    void ShareSurfaceTable(const std::shared_ptr<SurfaceTable>& table);
+
+    // distinct surfaces the halfspaces use
+    size_t GetNumSurfaces() const {return surface_ids_.size();}
+
+    // conservative box around the region, unbounded along any axis no
+    // halfspace limits
+    const BoundingBox& GetBoundingBox() const {return box_;}
+
+    // heap bytes held by the region, not counting the surface table it may
+    // share with other regions
+    size_t GetMemoryBytes() const;
+
+    // simplifies the region in place without changing which points it holds:
+    // drops duplicate halfspaces, clauses holding both sides of a surface and
+    // clauses implied by a smaller one, then orders halfspaces and clauses
+    // cheapest first so Contains and Distance short-circuit early
+    void Compile();
+
+  private:
+    // halfspaces and clause uses are stored as signed one based indices, +i
+    // for the positive side of entry i - 1 and -i for the negative side
+    static int32_t Encode(uint32_t index, bool positive) {
+      const int32_t encoded = static_cast<int32_t>(index) + 1;
+      return positive ? encoded : -encoded;
+    }
+    static uint32_t DecodeIndex(int32_t encoded) {
+      return static_cast<uint32_t>(encoded < 0 ? -encoded : encoded) - 1;
+    }
+    static bool DecodePositive(int32_t encoded) {return encoded > 0;}
+
+    // indices and boxes derived from the flat storage
+    void BuildAcceleration();
+
+    std::shared_ptr<const SurfaceTable> surfaces_;
+    // every halfspace of every clause back to back, encoded surface indices
+    std::vector<int32_t> halfspaces_;
+    // clause c is halfspaces_[clause_offsets_[c], clause_offsets_[c + 1])
+    std::vector<uint32_t> clause_offsets_;
+    // table indices of the surfaces used, ascending. distance walks number
+    // surfaces by their position here
+    std::vector<uint32_t> surface_ids_;
+    // encoded clauses using surface_ids_[i] are
+    // surface_uses_[surface_use_offsets_[i], surface_use_offsets_[i + 1])
+    std::vector<uint32_t> surface_use_offsets_;
+    std::vector<int32_t> surface_uses_;
+    // box of each clause, only kept with more than one clause, and their
+    // union, checked before any surface
+    std::vector<BoundingBox> clause_boxes_;
+    BoundingBox box_;
+  };
+
+  // region as an expression tree of halfspaces. unions of intersections of
+  // unions stay linear in size instead of expanding to a DNF product, and
+  // Contains short-circuits. plain Regions remain the better fit for simple
+  // cells, converting one (or a halfspace) is implicit so they mix in & and |.
+  // Geometry cells only take Regions, a CSGRegion is used on its own
+  class CSGRegion
+  {
+  public:
+    CSGRegion(const Halfspace& hs);
+
+    CSGRegion(const Region& region);
 
     bool Contains(const Point& p) const;
 
-    double Distance(const Point& p, const Direction& d) const;
+    // same crossing walk as Region::Distance, re-evaluating the tree from the
+    // sense bits after each crossing
+    double Distance(const Point& p, const Direction& d) const {
+      return NextCrossing(p, d).distance;
+    }
+
+    BoundaryCrossing NextCrossing(const Point& p, const Direction& d) const;
+
+    size_t GetNumNodes() const {return nodes_.size();}
+
+    const SurfaceTable& GetSurfaceTable() const {return surfaces_;}
+
+    const BoundingBox& GetBoundingBox() const {return box_;}
+
+    static CSGRegion Intersection(const CSGRegion& lhs, const CSGRegion& rhs) {
+      return Combine(Op::AND, lhs, rhs);
+    }
+
+    static CSGRegion Union(const CSGRegion& lhs, const CSGRegion& rhs) {
+      return Combine(Op::OR, lhs, rhs);
+    }
 
   private:
-    std::vector<std::vector<Halfspace>> clauses_;
+    enum class Op : uint8_t {HALFSPACE, AND, OR};
+
+    static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+    // nodes are stored children first with the root last. index is the
+    // surface of a halfspace or the left child of an operator, whose right
+    // child is always the node just before it. parent is the operator a left
+    // child belongs to, so a left value that settles it skips the right
+    // subtree
+    struct Node
+    {
+      Op op;
+      bool positive;
+      uint32_t index;
+      uint32_t parent{NO_PARENT};
+    };
+
+    static CSGRegion Combine(Op op, const CSGRegion& lhs, const CSGRegion& rhs);
+
+    uint32_t GetRoot() const {return static_cast<uint32_t>(nodes_.size() - 1);}
+
+    // walks the postfix nodes with an explicit stack, deep trees do not
+    // recurse
+    template <typename Sense>
+    bool Evaluate(const Sense& sense) const;
+
+    BoundingBox ComputeBoundingBox() const;
+
+    SurfaceTable surfaces_;
+    std::vector<Node> nodes_;
+    BoundingBox box_;
   };
 
   // operator overloads
@@ -106,6 +259,14 @@ namespace charmander
     clauses.insert(clauses.end(), rhs_clauses.begin(), rhs_clauses.end());
     return Region(clauses);
   }
+
+  inline CSGRegion operator&(const CSGRegion& lhs, const CSGRegion& rhs) {
+    return CSGRegion::Intersection(lhs, rhs);
+  }
+
+  inline CSGRegion operator|(const CSGRegion& lhs, const CSGRegion& rhs) {
+    return CSGRegion::Union(lhs, rhs);
+  }
 } // namespace charmander
 
 #endif // CHARMANDER_GEOMETRY_REGION_H_
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define CHARMANDER_GEOMETRY_SURFACE_H_
 
 #include "basic_types.h"
+#include "geometry/surface_table.h"
 
 namespace charmander {
 
@@ -17,6 +18,9 @@ class Surface {
 
   virtual double Distance(Point p, Direction d) const = 0;
 
+  // type tag and coefficients for a SurfaceTable
+  virtual SurfaceData Pack() const = 0;
+
  protected:
   int id_;
 };
@@ -0,0 +1,237 @@
+#ifndef CHARMANDER_GEOMETRY_SURFACE_TABLE_H_
+#define CHARMANDER_GEOMETRY_SURFACE_TABLE_H_
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "basic_types.h"
+#include "constants.h"
+
+namespace charmander {
+
+class Surface;
+
+// ----------------------------------------------------------------------------
+// SurfaceData
+// ----------------------------------------------------------------------------
+
+enum class SurfaceType : uint8_t {
+  PLANE,
+  X_PLANE,
+  Y_PLANE,
+  Z_PLANE,
+  CYLINDER,
+  X_CYLINDER,
+  Y_CYLINDER,
+  Z_CYLINDER,
+};
+
+// a surface as a type tag plus packed coefficients, laid out per type as
+//   PLANE        a, b, c, d
+//   X/Y/Z_PLANE  x0 / y0 / z0
+//   CYLINDER     r^2, axis x, y, z, center x, y, z
+//   X_CYLINDER   r^2, y0, z0 (Y_ and Z_CYLINDER take the other two axes)
+struct SurfaceData {
+  SurfaceType type;
+  std::array<double, 7> coeffs{};
+};
+static_assert(sizeof(SurfaceData) == CACHE_LINE_BYTES);
+
+// rough relative cost of a sense or distance evaluation
+inline int SurfaceCost(SurfaceType type) {
+  switch (type) {
+    case SurfaceType::X_PLANE:
+    case SurfaceType::Y_PLANE:
+    case SurfaceType::Z_PLANE:
+      return 1;
+    case SurfaceType::PLANE:
+      return 2;
+    case SurfaceType::X_CYLINDER:
+    case SurfaceType::Y_CYLINDER:
+    case SurfaceType::Z_CYLINDER:
+      return 3;
+    case SurfaceType::CYLINDER:
+      return 6;
+  }
+  return 6;
+}
+
+// ----------------------------------------------------------------------------
+// Inline surface kernels
+// ----------------------------------------------------------------------------
+
+// nearest root of A t^2 + B t + C past after. distance kernels take after so
+// callers can walk successive crossings of the same surface along a ray
+inline double QuadraticSurfaceDistance(double A, double B, double C,
+                                       double after = 0.0) {
+  if (std::abs(A) < FP_TOLERANCE) return INF;
+
+  const double discriminant = B * B - 4 * A * C;
+  if (discriminant < 0.0) return INF;
+
+  const double sqrt_disc = std::sqrt(discriminant);
+  const double r1 = (-B - sqrt_disc) / (2 * A);
+  const double r2 = (-B + sqrt_disc) / (2 * A);
+
+  const double threshold = after + COINCIDENT_SURF;
+  double distance = INF;
+  if (r1 > threshold) distance = r1;
+  if (r2 > threshold && r2 < distance) distance = r2;
+  return distance;
+}
+
+inline double AxisPlaneDistance(double x, double u, double x0,
+                                double after = 0.0) {
+  if (std::abs(u) < FP_TOLERANCE) return INF;
+  const double distance = -(x - x0) / u;
+  return (distance > after + COINCIDENT_SURF) ? distance : INF;
+}
+
+// cylinder along the third axis, given the two transverse coordinates
+inline double AxisCylinderEvaluate(double x, double y, double r2, double x0,
+                                   double y0) {
+  const double wx = x - x0;
+  const double wy = y - y0;
+  return wx * wx + wy * wy - r2;
+}
+
+inline double AxisCylinderDistance(double x, double y, double u, double v,
+                                   double r2, double x0, double y0,
+                                   double after = 0.0) {
+  const double wx = x - x0;
+  const double wy = y - y0;
+  return QuadraticSurfaceDistance(u * u + v * v, 2 * (wx * u + wy * v),
+                                  wx * wx + wy * wy - r2, after);
+}
+
+inline double EvaluateSurface(const SurfaceData& s, const Point& p) {
+  const auto& c = s.coeffs;
+  switch (s.type) {
+    case SurfaceType::PLANE:
+      return c[0] * p.x + c[1] * p.y + c[2] * p.z - c[3];
+    case SurfaceType::X_PLANE:
+      return p.x - c[0];
+    case SurfaceType::Y_PLANE:
+      return p.y - c[0];
+    case SurfaceType::Z_PLANE:
+      return p.z - c[0];
+    case SurfaceType::CYLINDER: {
+      const double wx = p.x - c[4];
+      const double wy = p.y - c[5];
+      const double wz = p.z - c[6];
+      const double wu = wx * c[1] + wy * c[2] + wz * c[3];
+      const double px = wx - wu * c[1];
+      const double py = wy - wu * c[2];
+      const double pz = wz - wu * c[3];
+      return px * px + py * py + pz * pz - c[0];
+    }
+    case SurfaceType::X_CYLINDER:
+      return AxisCylinderEvaluate(p.y, p.z, c[0], c[1], c[2]);
+    case SurfaceType::Y_CYLINDER:
+      return AxisCylinderEvaluate(p.x, p.z, c[0], c[1], c[2]);
+    case SurfaceType::Z_CYLINDER:
+      return AxisCylinderEvaluate(p.x, p.y, c[0], c[1], c[2]);
+  }
+  return INF;
+}
+
+inline bool SurfaceSense(const SurfaceData& s, const Point& p) {
+  return !std::signbit(EvaluateSurface(s, p));
+}
+
+inline double SurfaceDistance(const SurfaceData& s, const Point& p,
+                              const Direction& d, double after = 0.0) {
+  const auto& c = s.coeffs;
+  switch (s.type) {
+    case SurfaceType::PLANE: {
+      const double denominator = d.x * c[0] + d.y * c[1] + d.z * c[2];
+      if (std::abs(denominator) < FP_TOLERANCE) return INF;
+      const double distance = -EvaluateSurface(s, p) / denominator;
+      return (distance > after + COINCIDENT_SURF) ? distance : INF;
+    }
+    case SurfaceType::X_PLANE:
+      return AxisPlaneDistance(p.x, d.x, c[0], after);
+    case SurfaceType::Y_PLANE:
+      return AxisPlaneDistance(p.y, d.y, c[0], after);
+    case SurfaceType::Z_PLANE:
+      return AxisPlaneDistance(p.z, d.z, c[0], after);
+    case SurfaceType::CYLINDER: {
+      const double wx = p.x - c[4];
+      const double wy = p.y - c[5];
+      const double wz = p.z - c[6];
+      const double wu = wx * c[1] + wy * c[2] + wz * c[3];
+      const double du = d.x * c[1] + d.y * c[2] + d.z * c[3];
+      const double wpx = wx - wu * c[1];
+      const double wpy = wy - wu * c[2];
+      const double wpz = wz - wu * c[3];
+      const double dpx = d.x - du * c[1];
+      const double dpy = d.y - du * c[2];
+      const double dpz = d.z - du * c[3];
+      return QuadraticSurfaceDistance(
+          dpx * dpx + dpy * dpy + dpz * dpz,
+          2 * (wpx * dpx + wpy * dpy + wpz * dpz),
+          wpx * wpx + wpy * wpy + wpz * wpz - c[0], after);
+    }
+    case SurfaceType::X_CYLINDER:
+      return AxisCylinderDistance(p.y, p.z, d.y, d.z, c[0], c[1], c[2],
+                                  after);
+    case SurfaceType::Y_CYLINDER:
+      return AxisCylinderDistance(p.x, p.z, d.x, d.z, c[0], c[1], c[2],
+                                  after);
+    case SurfaceType::Z_CYLINDER:
+      return AxisCylinderDistance(p.x, p.y, d.x, d.y, c[0], c[1], c[2],
+                                  after);
+  }
+  return INF;
+}
+
+// ----------------------------------------------------------------------------
+// SurfaceTable
+// ----------------------------------------------------------------------------
+
+// flat store of packed surfaces. lookups switch on the type tag instead of
+// calling through Surface's vtable, so the math inlines into the caller
+class SurfaceTable {
+ public:
+  // index of the surface in the table, packing it on first use. surfaces are
+  // identified by address, the same object always maps to the same index
+  uint32_t Add(const Surface& surface);
+
+  // frees the address lookup once a table is built. the next Add rebuilds it
+  void ReleaseIndex();
+
+  // heap bytes held by the table
+  size_t GetMemoryBytes() const;
+
+  size_t Size() const { return surfaces_.size(); }
+
+  const SurfaceData& operator[](size_t i) const { return surfaces_[i]; }
+
+  // the object entry i was packed from
+  const Surface& GetSurface(size_t i) const { return *sources_[i]; }
+
+  double Evaluate(size_t i, const Point& p) const {
+    return EvaluateSurface(surfaces_[i], p);
+  }
+
+  bool Sense(size_t i, const Point& p) const {
+    return SurfaceSense(surfaces_[i], p);
+  }
+
+  double Distance(size_t i, const Point& p, const Direction& d,
+                  double after = 0.0) const {
+    return SurfaceDistance(surfaces_[i], p, d, after);
+  }
+
+ private:
+  std::vector<SurfaceData> surfaces_;
+  std::vector<const Surface*> sources_;
+  std::unordered_map<const Surface*, uint32_t> index_;
+};
+
+}  // namespace charmander
+
+#endif  // CHARMANDER_GEOMETRY_SURFACE_TABLE_H_
@@ -0,0 +1,87 @@
+#ifndef CHARMANDER_GEOMETRY_UNIVERSE_H_
+#define CHARMANDER_GEOMETRY_UNIVERSE_H_
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "basic_types.h"
+#include "geometry/bounding_box.h"
+#include "geometry/region.h"
+
+namespace charmander {
+
+// ----------------------------------------------------------------------------
+// Cell
+// ----------------------------------------------------------------------------
+
+enum class FillType : uint8_t {
+  MATERIAL,
+  UNIVERSE,
+  LATTICE,
+};
+
+// a region filled with a material, or with a universe or lattice that is
+// searched further in the same coordinates
+struct Cell {
+  Region region;
+  int material_id;
+  FillType fill{FillType::MATERIAL};
+  // universe or lattice id for the non material fills
+  uint32_t fill_index{0};
+  // universe holding the cell
+  uint32_t universe{0};
+};
+
+// ----------------------------------------------------------------------------
+// Universe
+// ----------------------------------------------------------------------------
+
+// set of cells searched through a bounding volume hierarchy over the cell
+// boxes. cells live in the owning Geometry, the universe holds their
+// indices. cells are assumed not to overlap
+class Universe {
+ public:
+  void AddCell(uint32_t cell) {
+    cells_.push_back(cell);
+    finalized_ = false;
+  }
+
+  const std::vector<uint32_t>& GetCells() const { return cells_; }
+
+  // builds the bvh over the given cells
+  void Finalize(const std::vector<Cell>& cells);
+
+  bool IsFinalized() const { return finalized_; }
+
+  // cell containing p, if any. O(log N) through the bvh for cells with a
+  // bounded box, plus a linear pass over cells unbounded on every axis
+  std::optional<uint32_t> FindCell(const std::vector<Cell>& cells,
+                                   const Point& p) const;
+
+  size_t GetNumBVHNodes() const { return bvh_nodes_.size(); }
+
+ private:
+  // leaf when count > 0 and holds bvh_cells_[first, first + count). an
+  // interior node's children are the next node and node first
+  struct BVHNode {
+    BoundingBox box;
+    uint32_t first;
+    uint32_t count;
+  };
+
+  // bvh_cells_ holds positions into boxes and centroids while building
+  uint32_t BuildBVH(size_t begin, size_t end,
+                    const std::vector<BoundingBox>& boxes,
+                    const std::vector<Point>& centroids);
+
+  std::vector<uint32_t> cells_;
+  std::vector<BVHNode> bvh_nodes_;
+  std::vector<uint32_t> bvh_cells_;
+  std::vector<uint32_t> unbounded_cells_;
+  bool finalized_{false};
+};
+
+}  // namespace charmander
+
+#endif  // CHARMANDER_GEOMETRY_UNIVERSE_H_
@@ -2,6 +2,7 @@
 #define CHARMANDER_MATERIALS_CE_MATERIAL_H_
 
 #include <memory>
+#include <span>
 #include <vector>
 
 #include "materials/nuclide.h"
@@ -9,28 +10,74 @@
 namespace charmander
 {
 
+  // how a material finds each nuclide's energy bin
+  enum class EnergySearch {
+    BINARY,      // binary search over each nuclide grid
+    HASH,        // each nuclide's log-energy hash
+    UNION_GRID,  // one search on the material union grid
+  };
+
   struct NuclideData {
-    std::shared_ptr<const Nuclide> nuc; 
+    std::shared_ptr<const Nuclide> nuc;
     double atom_percent;
   };
 
   class CEMaterial
   {
   public:
-    CEMaterial(const int id, const std::vector<NuclideData>& nuclide_data);
-  
+    CEMaterial(const int id, const std::vector<NuclideData>& nuclide_data,
+               EnergySearch search = EnergySearch::UNION_GRID);
+
     const int GetID() const {return id_;}
     const std::vector<NuclideData>& GetNuclides() const {return nuclides_;}
+    EnergySearch GetEnergySearch() const {return search_;}
+    // union grid is only built for EnergySearch::UNION_GRID or a total xs table
+    const std::vector<double>& GetUnionEnergies() const {return union_energies_;}
+
+    // bytes held by the energy search acceleration structures
+    size_t GetSearchMemoryBytes() const;
+
+    // opt in to a macroscopic total xs table on the union energies. trades
+    // GetTotalXSTableMemoryBytes() of memory for a single search and
+    // interpolation per GetTotalXS, independent of the nuclide count
+    void PrecomputeTotalXS();
+    bool HasTotalXSTable() const {return !total_xs_table_.empty();}
+    size_t GetTotalXSTableMemoryBytes() const;
+
+    size_t GetUnionEnergyBin(double energy) const;
     double GetTotalXS(double energy) const;
+    // batched total xs, xs[i] at energies[i]. walks the batch one nuclide at
+    // a time so each nuclide's grid stays in cache across the batch
+    void GetTotalXS(std::span<const double> energies, std::span<double> xs) const;
     double GetXSFromMT(MT mt, double energy) const;
+    // every channel from one energy search per nuclide
+    ReactionXS GetAllXS(double energy) const;
 
   private:
+    void BuildUnionEnergies();
+    void BuildUnionGrid();
+
+    double GetTabulatedTotalXS(double energy) const;
+
+    // calls func(nuclide_data, lower_energy_bin) for every nuclide
+    template <typename Func>
+    void ForEachNuclideBin(double energy, Func&& func) const;
+
     const int id_;
     std::vector<NuclideData> nuclides_;
+    EnergySearch search_;
+
+    // union of every nuclide's evaluation energies
+    std::vector<double> union_energies_;
+    // lower energy bin of each nuclide at each union energy, stored energy
+    // major: union_index_map_[union_bin * nuclides_.size() + nuclide]
+    std::vector<size_t> union_index_map_;
+    // macroscopic total xs at each union energy, empty unless precomputed
+    std::vector<double> total_xs_table_;
   };
-  
+
 } // namespace charmander
 
 
 
-#endif // CHARMANDER_MATERIALS_CE_MATERIAL_H_
\ No newline at end of file
+#endif // CHARMANDER_MATERIALS_CE_MATERIAL_H_
@@ -1,44 +1,223 @@
 #ifndef CHARMANDER_MATERIALS_NUCLIDE_H_
 #define CHARMANDER_MATERIALS_NUCLIDE_H_
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
+#include "aligned_allocator.h"
+
 namespace charmander {
 enum MT {
+  TOTAL = 1,
   ELASTIC = 2,
   INELASTIC = 4,
   FISSION = 18,
   CAPTURE = 102,
 };
 
+// column of each reaction inside an interleaved xs record
+enum XSChannel : size_t {
+  TOTAL_CHANNEL = 0,
+  ELASTIC_CHANNEL,
+  INELASTIC_CHANNEL,
+  FISSION_CHANNEL,
+  CAPTURE_CHANNEL,
+  NUM_XS_CHANNELS,
+};
+
+// floats per energy point. padded from NUM_XS_CHANNELS so a record never
+// straddles a cache line and a bin's two bracketing records span at most two
+constexpr size_t XS_RECORD_STRIDE = 8;
+static_assert(XS_RECORD_STRIDE >= NUM_XS_CHANNELS);
+static_assert(CACHE_LINE_BYTES % (2 * XS_RECORD_STRIDE * sizeof(float)) == 0);
+
+inline size_t ChannelFromMT(MT mt) {
+  switch (mt) {
+    case MT::TOTAL:
+      return TOTAL_CHANNEL;
+    case MT::ELASTIC:
+      return ELASTIC_CHANNEL;
+    case MT::INELASTIC:
+      return INELASTIC_CHANNEL;
+    case MT::FISSION:
+      return FISSION_CHANNEL;
+    case MT::CAPTURE:
+      return CAPTURE_CHANNEL;
+  }
+  throw std::out_of_range("unsupported MT " + std::to_string(mt));
+}
+
+// set of XSChannels, bit c selects channel c
+using ChannelMask = uint32_t;
+constexpr ChannelMask ALL_CHANNELS = (ChannelMask{1} << NUM_XS_CHANNELS) - 1;
+
+inline ChannelMask ChannelMaskFromMTs(const std::vector<MT>& mts) {
+  ChannelMask mask = 0;
+  for (MT mt : mts) mask |= ChannelMask{1} << ChannelFromMT(mt);
+  return mask;
+}
+
+// every reaction channel at one energy, indexed by XSChannel
+struct ReactionXS {
+  std::array<double, NUM_XS_CHANNELS> xs{};
+
+  double Total() const { return xs[TOTAL_CHANNEL]; }
+  double FromMT(MT mt) const { return xs[ChannelFromMT(mt)]; }
+};
+
+class MappedFile;
+class XSFileInterface;
+
 class Nuclide {
  public:
-  Nuclide(std::string nuclide) : nuclide_name_(nuclide){};
+  Nuclide(std::string nuclide, std::string temperature = "294K")
+      : nuclide_name_(nuclide), temperature_(temperature){};
+
+  // the grid and table views point into this object or its mapping
+  Nuclide(const Nuclide&) = delete;
+  Nuclide& operator=(const Nuclide&) = delete;
+
+  // uses the binary cache under CHARMANDER_XS_CACHE when one exists,
+  // otherwise reads the HDF5 library. only the required channels are read
+  // from HDF5 up front, the others on first access. the total is built from
+  // every partial channel, so requiring it reads them all
+  void LoadFromFile(ChannelMask required = ALL_CHANNELS);
+
+  // always reads the HDF5 library, ignoring any cache
+  void LoadFromHDF5(ChannelMask required = ALL_CHANNELS);
+
+  // maps a binary cache written by WriteXSCache. the energies and records
+  // are used in place, so processes mapping one file share its pages
+  void LoadFromXSCache(const std::string& path);
+
+  void WriteXSCache(const std::string& path) const;
+
+  bool AlreadyLoaded() const {
+    return loaded_.load(std::memory_order_acquire);
+  }
 
-  void LoadFromFile();
-  
-  bool AlreadyLoaded() const {return loaded_;}
+  bool IsChannelLoaded(MT mt) const {
+    return channel_loaded_[ChannelFromMT(mt)].load(std::memory_order_acquire);
+  }
 
+  // true when the data lives in a mapped cache rather than private memory
+  bool IsMapped() const { return static_cast<bool>(mapping_); }
+
+  const std::string& GetName() const { return nuclide_name_; }
+  const std::string& GetTemperature() const { return temperature_; }
+
+  std::span<const double> GetEvaluationEnergies() const {
+    return evaluation_energies_;
+  }
+
+  // hash accelerated search, only scans the points in the energy's bucket
   size_t GetLowerEnergyBin(double energy) const;
 
+  // plain binary search over the full grid
+  size_t BinarySearchEnergyBin(double energy) const;
+
+  size_t GetEnergyHashMemoryBytes() const {
+    return energy_hash_bounds_.size() * sizeof(size_t);
+  }
+
   double GetTotalXS(size_t energy_index, double energy) const;
 
+  // batched total xs, xs[i] at energies[i]. searches a pass of energies,
+  // prefetching their records, then interpolates the pass with SIMD gathers
+  void GetTotalXS(std::span<const double> energies,
+                  std::span<double> xs) const;
+
   double GetXSFromMT(MT mt, size_t energy_index, double energy) const;
 
+  // every channel from one record pair and one interpolation weight
+  ReactionXS GetAllXS(size_t energy_index, double energy) const;
+
+  // all channels at one energy point, indexed by XSChannel
+  const float* GetXSRecord(size_t energy_index) const {
+    EnsureAllChannels();
+    return xs_table_.data() + energy_index * XS_RECORD_STRIDE;
+  }
+
+  // first energy index a reaction is tabulated at, zero below it
+  size_t GetThresholdIndex(MT mt) const {
+    EnsureChannel(ChannelFromMT(mt));
+    return threshold_index_[ChannelFromMT(mt)];
+  }
+
+  size_t GetXSTableMemoryBytes() const {
+    return xs_table_.size_bytes();
+  }
+
  private:
-  void ConstructTotalXS();
+  double GetXSFromChannel(size_t channel, size_t energy_index,
+                          double energy) const;
+
+  // lazy loading, safe to call from any thread once the nuclide is loaded
+  void EnsureChannel(size_t channel) const {
+    if (!channel_loaded_[channel].load(std::memory_order_acquire)) {
+      LoadChannel(channel);
+    }
+  }
+  void EnsureAllChannels() const {
+    if (!all_channels_loaded_.load(std::memory_order_acquire)) {
+      for (size_t channel = 0; channel < NUM_XS_CHANNELS; ++channel) {
+        EnsureChannel(channel);
+      }
+      all_channels_loaded_.store(true, std::memory_order_release);
+    }
+  }
+  void LoadChannel(size_t channel) const;
+  // callers hold channel_mutex_
+  void LoadChannelLocked(size_t channel) const;
+  void ReadChannel(const XSFileInterface& xs_file, size_t channel) const;
+  void MarkChannelLoaded(size_t channel) const {
+    channel_loaded_[channel].store(true, std::memory_order_release);
+  }
+
+  void ConstructTotalXS() const;
+
+  void BuildEnergyHash();
+
+  size_t GetEnergyHashBucket(double energy) const;
 
   std::string nuclide_name_;
-  std::string temperature_ = "294K";
+  std::string temperature_;
+
+  // views of either the private storage below or a mapped cache
+  std::span<const double> evaluation_energies_;
+
+  // equal-lethargy buckets over the grid. energy_hash_bounds_[b] is the first
+  // grid index whose bucket is >= b, so bucket b only covers the points in
+  // [energy_hash_bounds_[b], energy_hash_bounds_[b + 1]]
+  double energy_hash_min_;
+  double energy_hash_log_min_;
+  double energy_hash_inv_width_;
+  std::vector<size_t> energy_hash_bounds_;
+
+  // energy-point-major records of XS_RECORD_STRIDE floats, one column per
+  // XSChannel, so a lookup of every channel touches one or two cache lines
+  std::span<const float> xs_table_;
+  // threshold reactions are read unpadded starting at their threshold index
+  mutable std::array<size_t, NUM_XS_CHANNELS> threshold_index_{};
 
-  std::vector<double> evaluation_energies_;
+  std::vector<double> energy_storage_;
+  // lazily loaded channels fill their column after the nuclide is loaded
+  mutable AlignedVector<float> xs_storage_;
+  std::shared_ptr<const MappedFile> mapping_;
 
-  std::vector<float> total_xs_;
-  std::unordered_map<MT, std::vector<float>> xs_map_;
+  // published last, readers on other threads see fully loaded data
+  std::atomic<bool> loaded_{false};
 
-  bool loaded_{false};
+  mutable std::mutex channel_mutex_;
+  mutable std::array<std::atomic<bool>, NUM_XS_CHANNELS> channel_loaded_{};
+  mutable std::atomic<bool> all_channels_loaded_{false};
 };
 
 }  // namespace charmander
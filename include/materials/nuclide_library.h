@@ -0,0 +1,53 @@
+#ifndef CHARMANDER_MATERIALS_NUCLIDE_LIBRARY_H_
+#define CHARMANDER_MATERIALS_NUCLIDE_LIBRARY_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "materials/nuclide.h"
+
+namespace charmander {
+
+// thread safe registry of loaded nuclides keyed by name and temperature, so
+// every material using a nuclide shares one copy of its data
+class NuclideLibrary {
+ public:
+  // the shared nuclide, loaded on first request. concurrent requests for the
+  // same nuclide wait for one load, different nuclides load concurrently.
+  // the first request decides which channels are read up front, any others
+  // are read on first access
+  std::shared_ptr<const Nuclide> Get(const std::string& nuclide,
+                                     const std::string& temperature = "294K",
+                                     ChannelMask required = ALL_CHANNELS);
+
+  // loads every nuclide not loaded yet with n_threads workers (0 picks the
+  // hardware concurrency). rethrows the first load failure after all
+  // workers finish
+  void LoadAll(const std::vector<std::string>& nuclides,
+               const std::string& temperature = "294K", size_t n_threads = 0,
+               ChannelMask required = ALL_CHANNELS);
+
+  bool Contains(const std::string& nuclide,
+                const std::string& temperature = "294K") const;
+
+  size_t Size() const;
+
+ private:
+  struct Entry {
+    std::once_flag loaded;
+    std::shared_ptr<Nuclide> nuclide;
+  };
+
+  using Key = std::pair<std::string, std::string>;
+
+  mutable std::mutex mutex_;
+  std::map<Key, std::shared_ptr<Entry>> entries_;
+};
+
+}  // namespace charmander
+
+#endif  // CHARMANDER_MATERIALS_NUCLIDE_LIBRARY_H_
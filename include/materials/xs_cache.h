@@ -0,0 +1,101 @@
+#ifndef CHARMANDER_MATERIALS_XS_CACHE_H_
+#define CHARMANDER_MATERIALS_XS_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+
+#include "aligned_allocator.h"
+#include "materials/nuclide.h"
+
+namespace charmander {
+
+// bump whenever the layout below or the meaning of a record changes
+constexpr uint32_t XS_CACHE_VERSION = 2;
+constexpr char XS_CACHE_MAGIC[8] = {'C', 'H', 'M', 'R', 'X', 'S', '\0', '\0'};
+constexpr uint32_t XS_CACHE_ENDIAN_CHECK = 0x01020304;
+
+// fixed header at the start of a cache file. the energies and interleaved
+// records follow at cache line aligned offsets so they can be used in place
+// from a mapping
+struct XSCacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t endian_check;
+  char nuclide[32];
+  char temperature[16];
+  uint64_t record_stride;
+  uint64_t num_channels;
+  uint64_t n_energies;
+  uint64_t energies_offset;
+  uint64_t table_offset;
+  uint64_t threshold_index[NUM_XS_CHANNELS];
+};
+
+// ----------------------------------------------------------------------------
+// MappedFile
+// ----------------------------------------------------------------------------
+
+// read only view of a whole file. uses a shared mmap so every process
+// mapping the same file shares one copy in the page cache
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const std::byte* Data() const { return data_; }
+  size_t Size() const { return size_; }
+
+ private:
+  const std::byte* data_{nullptr};
+  size_t size_{0};
+#ifdef _WIN32
+  // no mmap, the file is read into an aligned buffer instead
+  AlignedVector<std::byte> buffer_;
+#endif
+};
+
+// ----------------------------------------------------------------------------
+// XSCache
+// ----------------------------------------------------------------------------
+
+class XSCache {
+ public:
+  // <CHARMANDER_XS_CACHE>/<nuclide>_<temperature>.cxs if the variable is set
+  // and the file exists
+  static std::optional<std::string> ResolveCachePath(
+      const std::string& nuclide, const std::string& temperature);
+
+  static std::string CacheFileName(const std::string& nuclide,
+                                   const std::string& temperature);
+
+  static void Write(const std::string& path, const std::string& nuclide,
+                    const std::string& temperature,
+                    std::span<const double> energies,
+                    std::span<const float> table,
+                    std::span<const size_t, NUM_XS_CHANNELS> threshold_index);
+
+  // maps and validates a cache file, throws on any mismatch
+  explicit XSCache(const std::string& path);
+
+  const XSCacheHeader& GetHeader() const { return header_; }
+  std::span<const double> GetEnergies() const { return energies_; }
+  std::span<const float> GetTable() const { return table_; }
+  std::shared_ptr<const MappedFile> GetMapping() const { return mapping_; }
+
+ private:
+  std::shared_ptr<const MappedFile> mapping_;
+  XSCacheHeader header_;
+  std::span<const double> energies_;
+  std::span<const float> table_;
+};
+
+}  // namespace charmander
+
+#endif  // CHARMANDER_MATERIALS_XS_CACHE_H_
@@ -3,6 +3,7 @@
 
 #include <hdf5.h>
 
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -14,6 +15,10 @@ class XSFileInterface {
 
   static std::string ResolveFilePath(const std::string& nuclide);
 
+  // holds the process wide HDF5 lock unless the library was built thread
+  // safe. keep it for the lifetime of any interface used off the main thread
+  static std::unique_lock<std::mutex> LockHDF5();
+
   hid_t OpenXSFile(
       const std::string& filename) const;  // probs shouldnt be public...
 
@@ -35,10 +40,27 @@ class XSFileInterface {
                               std::vector<float>& xs,
                               const size_t& target_size) const;
 
+  // reads straight into strided storage, xs[i * stride] for every energy
+  void Load1DXSDataset(const std::string& mt_rxn,
+                       const std::string& temperature, float* xs,
+                       const size_t& stride, const size_t& target_size) const;
+
+  // reads a threshold reaction straight into strided storage without
+  // padding. the data starts at the returned threshold index, so only
+  // xs[i * stride] for i in [threshold_index, target_size) is written
+  size_t LoadThreshold1DXSDataset(const std::string& mt_rxn,
+                                  const std::string& temperature, float* xs,
+                                  const size_t& stride,
+                                  const size_t& target_size) const;
+
   std::string Get1DXSDataPath(const std::string& mt_rxn,
                               const std::string& temperature) const;
 
  private:
+  void ReadStrided1DXSDataset(const std::string& mt_rxn,
+                              const std::string& path, float* xs,
+                              const size_t& stride, const size_t& size) const;
+
   const std::string nuclide_;
   hid_t file_id_;
 };
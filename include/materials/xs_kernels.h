@@ -0,0 +1,33 @@
+#ifndef CHARMANDER_MATERIALS_XS_KERNELS_H_
+#define CHARMANDER_MATERIALS_XS_KERNELS_H_
+
+#include <cstddef>
+
+namespace charmander {
+
+// energies handed to the batch kernels per pass, sized so the bins and
+// clipped energies of a pass stay on the stack and in L1
+constexpr size_t XS_BATCH_SIZE = 256;
+
+inline void PrefetchRead(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(address, 0, 1);
+#endif
+}
+
+// xs[i] = linear interpolation at energies[i] between points bins[i] and
+// bins[i] + 1 of a grid, where the xs of point j is column[j *
+// XS_RECORD_STRIDE]. energies must already be clipped to the grid. uses
+// AVX-512 or AVX2 gathers when the build targets them.
+void InterpolateRecordColumn(const double* grid, const float* column,
+                             const size_t* bins, const double* energies,
+                             double* xs, size_t n);
+
+// same as InterpolateRecordColumn for a dense table of doubles
+void InterpolateTable(const double* grid, const double* table,
+                      const size_t* bins, const double* energies, double* xs,
+                      size_t n);
+
+}  // namespace charmander
+
+#endif  // CHARMANDER_MATERIALS_XS_KERNELS_H_
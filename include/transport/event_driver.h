@@ -0,0 +1,58 @@
+#ifndef CHARMANDER_TRANSPORT_EVENT_DRIVER_H_
+#define CHARMANDER_TRANSPORT_EVENT_DRIVER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "transport/transport.h"
+
+namespace charmander {
+
+// transports a batch of particles one event type at a time. particles wait
+// in a queue per next event (xs lookup, advance, surface crossing,
+// collision) and each kernel runs over a whole queue. delta tracked
+// flights queue for a lookup at their tentative collision point, which is
+// accepted or rejected before the next advance. the lookup queue is
+// sorted by material and energy, so lookups for one material run as a
+// single batched CEMaterial::GetTotalXS over neighbouring grid points, and
+// the collision queue inherits that order. per particle random streams
+// match HistoryDriver, so both modes give the same histories. batches are
+// tallied on their own and summed in order, so the result does not depend on
+// the thread count
+class EventDriver {
+ public:
+  // particles in flight per batch on each worker
+  static constexpr size_t DEFAULT_BATCH_SIZE = 4096;
+
+  explicit EventDriver(const TransportProblem& problem,
+                       size_t batch_size = DEFAULT_BATCH_SIZE);
+
+  // n_particles histories in batches spread over n_threads workers (0 picks
+  // the hardware concurrency). rethrows the first worker failure after all
+  // finish
+  TransportTally Run(uint64_t n_particles, uint64_t seed = 1,
+                     size_t n_threads = 0) const;
+
+  // particles [first, first + n) through the event loop
+  void TransportBatch(uint64_t first, size_t n, uint64_t seed,
+                      TransportTally& tally) const;
+
+ private:
+  struct Batch;
+
+  void LookupXS(Batch& batch) const;
+  void SampleTentative(Batch& batch, TransportTally& tally) const;
+  void Advance(Batch& batch, TransportTally& tally) const;
+  // delta tracked flight of particle i from the uniform xi
+  void AdvanceDelta(Batch& batch, uint32_t i, double xi,
+                    TransportTally& tally) const;
+  void CrossSurfaces(Batch& batch, TransportTally& tally) const;
+  void Collide(Batch& batch, TransportTally& tally) const;
+
+  const TransportProblem& problem_;
+  size_t batch_size_;
+};
+
+}  // namespace charmander
+
+#endif  // CHARMANDER_TRANSPORT_EVENT_DRIVER_H_
@@ -0,0 +1,41 @@
+#ifndef CHARMANDER_TRANSPORT_HISTORY_DRIVER_H_
+#define CHARMANDER_TRANSPORT_HISTORY_DRIVER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "transport/transport.h"
+
+namespace charmander {
+
+// follows each particle from birth to death before starting the next. in
+// surface tracked cells it samples a flight distance, compares it with the
+// next boundary, then either crosses into the next cell or collides. in
+// delta tracked cells it flies against the majorant and locates the
+// tentative collision point instead. worker threads take chunks of
+// histories from a shared counter and only share the read only problem, so
+// the hot loop has no locks and nothing written by more than one thread.
+// each chunk is tallied on its own and the chunks are summed in order, so the
+// result does not depend on the thread count
+class HistoryDriver {
+ public:
+  // histories a worker claims at a time
+  static constexpr uint64_t CHUNK_SIZE = 64;
+
+  explicit HistoryDriver(const TransportProblem& problem);
+
+  // n_particles histories on n_threads workers (0 picks the hardware
+  // concurrency). rethrows the first worker failure after all finish
+  TransportTally Run(uint64_t n_particles, uint64_t seed = 1,
+                     size_t n_threads = 0) const;
+
+  // one history, particle picks its random stream
+  void Transport(uint64_t particle, uint64_t seed, TransportTally& tally) const;
+
+ private:
+  const TransportProblem& problem_;
+};
+
+}  // namespace charmander
+
+#endif  // CHARMANDER_TRANSPORT_HISTORY_DRIVER_H_
@@ -0,0 +1,76 @@
+#ifndef CHARMANDER_TRANSPORT_PARTICLE_BANK_H_
+#define CHARMANDER_TRANSPORT_PARTICLE_BANK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "aligned_allocator.h"
+#include "basic_types.h"
+
+namespace charmander {
+
+// ----------------------------------------------------------------------------
+// ParticleBank
+// ----------------------------------------------------------------------------
+
+// particle state as a structure of arrays. each field is its own cache line
+// aligned array, so a kernel over one field streams through dense memory
+// and vectorizes, where an array of particle structs would stride over
+// fields it does not touch
+struct ParticleBank {
+  // cell of a particle not yet located
+  static constexpr int32_t NO_CELL = -1;
+
+  AlignedVector<double> x;
+  AlignedVector<double> y;
+  AlignedVector<double> z;
+  AlignedVector<double> u;
+  AlignedVector<double> v;
+  AlignedVector<double> w;
+  AlignedVector<double> E;
+  AlignedVector<double> weight;
+  AlignedVector<int32_t> cell;
+
+  ParticleBank() = default;
+  explicit ParticleBank(size_t capacity) { Reserve(capacity); }
+
+  size_t Size() const { return x.size(); }
+  bool Empty() const { return x.empty(); }
+
+  void Reserve(size_t capacity);
+
+  // new particles are zeroed with no cell
+  void Resize(size_t n);
+
+  void Clear() { Resize(0); }
+
+  // index of the appended particle
+  size_t Add(const Vec3& position, const Vec3& direction, double energy,
+             double particle_weight = 1.0, int32_t particle_cell = NO_CELL);
+
+  Vec3 GetPosition(size_t i) const { return Vec3(x[i], y[i], z[i]); }
+  Vec3 GetDirection(size_t i) const { return Vec3(u[i], v[i], w[i]); }
+
+  void SetPosition(size_t i, const Vec3& position) {
+    x[i] = position.x;
+    y[i] = position.y;
+    z[i] = position.z;
+  }
+
+  void SetDirection(size_t i, const Vec3& direction) {
+    u[i] = direction.x;
+    v[i] = direction.y;
+    w[i] = direction.z;
+  }
+
+  // exchanges every field of particles i and j
+  void Swap(size_t i, size_t j);
+
+  // moves particle i distances[i] along its direction, for every particle
+  void Advance(std::span<const double> distances);
+};
+
+}  // namespace charmander
+
+#endif  // CHARMANDER_TRANSPORT_PARTICLE_BANK_H_
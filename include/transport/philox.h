@@ -0,0 +1,130 @@
+#ifndef CHARMANDER_TRANSPORT_PHILOX_H_
+#define CHARMANDER_TRANSPORT_PHILOX_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+namespace charmander {
+
+// ----------------------------------------------------------------------------
+// Philox4x32-10
+// ----------------------------------------------------------------------------
+
+// counter based generator of Salmon et al., "Parallel random numbers: as easy
+// as 1, 2, 3" (SC11). each output block is a pure function of a 128 bit
+// counter and a 64 bit key, so any draw of any stream can be computed
+// directly without stepping through the ones before it
+using PhiloxCounter = std::array<uint32_t, 4>;
+using PhiloxKey = std::array<uint32_t, 2>;
+
+constexpr uint32_t PHILOX_M0 = 0xD2511F53;
+constexpr uint32_t PHILOX_M1 = 0xCD9E8D57;
+constexpr uint32_t PHILOX_W0 = 0x9E3779B9;
+constexpr uint32_t PHILOX_W1 = 0xBB67AE85;
+constexpr int PHILOX_ROUNDS = 10;
+
+inline PhiloxCounter Philox4x32(PhiloxCounter c, PhiloxKey k) {
+  for (int round = 0; round < PHILOX_ROUNDS; ++round) {
+    const uint64_t p0 = uint64_t{PHILOX_M0} * c[0];
+    const uint64_t p1 = uint64_t{PHILOX_M1} * c[2];
+    c = {static_cast<uint32_t>(p1 >> 32) ^ c[1] ^ k[0],
+         static_cast<uint32_t>(p1),
+         static_cast<uint32_t>(p0 >> 32) ^ c[3] ^ k[1],
+         static_cast<uint32_t>(p0)};
+    k[0] += PHILOX_W0;
+    k[1] += PHILOX_W1;
+  }
+  return c;
+}
+
+// top 53 bits as a double on [0, 1)
+inline double ToUniform(uint64_t bits) {
+  return static_cast<double>(bits >> 11) * 0x1.0p-53;
+}
+
+// ----------------------------------------------------------------------------
+// PhiloxStream
+// ----------------------------------------------------------------------------
+
+// 64 bit draws of one particle in one batch. the particle is the key, the
+// batch and block number the counter, so streams never overlap and are the
+// same whichever thread runs them. holds no shared state, and skipping
+// ahead any number of draws is O(1)
+class PhiloxStream {
+ public:
+  using result_type = uint64_t;
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  PhiloxStream(uint64_t batch, uint64_t particle)
+      : batch_(batch), particle_(particle) {}
+
+  // draw position of a stream, two per philox block
+  static uint64_t Draw(uint64_t batch, uint64_t particle, uint64_t position) {
+    return Word(Block(batch, particle, position >> 1), position & 1);
+  }
+
+  result_type operator()() {
+    const uint64_t block = position_ >> 1;
+    if (block != cached_block_) {
+      cached_ = Block(batch_, particle_, block);
+      cached_block_ = block;
+    }
+    return Word(cached_, position_++ & 1);
+  }
+
+  double Uniform() { return ToUniform((*this)()); }
+
+  void Skip(uint64_t n) { position_ += n; }
+
+  uint64_t GetBatch() const { return batch_; }
+  uint64_t GetParticle() const { return particle_; }
+  // draws taken so far
+  uint64_t GetPosition() const { return position_; }
+
+ private:
+  static PhiloxCounter Block(uint64_t batch, uint64_t particle,
+                             uint64_t block) {
+    return Philox4x32(
+        {static_cast<uint32_t>(block), static_cast<uint32_t>(block >> 32),
+         static_cast<uint32_t>(batch), static_cast<uint32_t>(batch >> 32)},
+        {static_cast<uint32_t>(particle),
+         static_cast<uint32_t>(particle >> 32)});
+  }
+
+  static uint64_t Word(const PhiloxCounter& block, uint64_t word) {
+    return word == 0 ? (uint64_t{block[1]} << 32 | block[0])
+                     : (uint64_t{block[3]} << 32 | block[2]);
+  }
+
+  uint64_t batch_;
+  uint64_t particle_;
+  uint64_t position_{0};
+  // philox block holding draws 2 cached_block_ and 2 cached_block_ + 1
+  uint64_t cached_block_{std::numeric_limits<uint64_t>::max()};
+  PhiloxCounter cached_{};
+};
+
+// ----------------------------------------------------------------------------
+// Batched fills
+// ----------------------------------------------------------------------------
+
+// out[i] = uniform draw first + i of one stream
+void FillUniforms(uint64_t batch, uint64_t particle, uint64_t first,
+                  std::span<double> out);
+
+// out[j] = next uniform of streams[indices[j]], advancing each. indices must
+// be distinct. the blocks of many streams are generated side by side, with
+// AVX2 when the build targets it
+void NextUniforms(std::span<PhiloxStream> streams,
+                  std::span<const uint32_t> indices, std::span<double> out);
+
+}  // namespace charmander
+
+#endif  // CHARMANDER_TRANSPORT_PHILOX_H_
@@ -0,0 +1,286 @@
+#ifndef CHARMANDER_TRANSPORT_TRANSPORT_H_
+#define CHARMANDER_TRANSPORT_TRANSPORT_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "basic_types.h"
+#include "constants.h"
+#include "geometry/geometry.h"
+#include "materials/ce_material.h"
+#include "materials/nuclide.h"
+#include "transport/philox.h"
+
+namespace charmander {
+
+// random stream of one particle history
+using TransportRNG = PhiloxStream;
+
+// stream of particle `particle` in batch (or run seed) batch. streams depend
+// only on the two, so results are bitwise the same for any thread count
+inline TransportRNG ParticleRNG(uint64_t batch, uint64_t particle) {
+  return TransportRNG(batch, particle);
+}
+
+// uniform on [0, 1)
+inline double Uniform(TransportRNG& rng) { return rng.Uniform(); }
+
+// ----------------------------------------------------------------------------
+// Source
+// ----------------------------------------------------------------------------
+
+// birth state of a source particle
+struct SourceSite {
+  Vec3 position;
+  Vec3 direction;
+  double energy;
+};
+
+using SourceSampler = std::function<SourceSite(TransportRNG&)>;
+
+SourceSampler IsotropicPointSource(const Vec3& position, double energy);
+
+// ----------------------------------------------------------------------------
+// Collision physics
+// ----------------------------------------------------------------------------
+
+enum class CollisionType : uint8_t {
+  SCATTER,
+  CAPTURE,
+  FISSION,
+};
+
+Vec3 SampleIsotropicDirection(TransportRNG& rng);
+
+// exponential flight distance from a uniform xi, INF in a void
+double CollisionDistance(double total_xs, double xi);
+
+// draws even in a void, so every history consumes its stream the same way
+inline double SampleCollisionDistance(double total_xs, TransportRNG& rng) {
+  return CollisionDistance(total_xs, Uniform(rng));
+}
+
+// whether a delta tracking collision is real, with probability total_xs /
+// majorant_xs. throws if the majorant does not bound the local xs
+bool AcceptDeltaCollision(double total_xs, double majorant_xs, double xi);
+
+// reaction picked by a uniform xi in proportion to the partial channels.
+// elastic and inelastic both scatter
+CollisionType SampleCollision(const ReactionXS& xs, double xi);
+
+inline CollisionType SampleCollision(const ReactionXS& xs, TransportRNG& rng) {
+  return SampleCollision(xs, Uniform(rng));
+}
+
+// ----------------------------------------------------------------------------
+// TransportTally
+// ----------------------------------------------------------------------------
+
+// event counts and per cell flux. surface tracked flights score their track
+// length, delta tracked flights score 1 / majorant at every real or virtual
+// collision, both estimate the same flux. filled per chunk of histories and
+// summed in chunk order by OrderedTallyReduction
+struct TransportTally {
+  uint64_t histories{0};
+  uint64_t collisions{0};
+  uint64_t crossings{0};
+  uint64_t captures{0};
+  uint64_t fissions{0};
+  uint64_t leaks{0};
+  // rejected delta tracking collisions
+  uint64_t virtual_collisions{0};
+  // born outside the geometry, stuck in an unbounded void or past the
+  // event limit
+  uint64_t lost{0};
+  std::vector<double> flux;
+
+  explicit TransportTally(size_t n_cells = 0) : flux(n_cells, 0.0) {}
+
+  void Merge(const TransportTally& other);
+
+  // zero every count and flux bin, keeping the flux storage
+  void Clear();
+};
+
+// sums the tallies of numbered work items (history chunks, event batches) in
+// item order whatever order the threads finish them in, so the result is
+// bitwise the same on any thread count. items are filled in a fixed window
+// of reused tallies and summed as soon as every item before them is, so a
+// thread claiming an item a full window past the oldest unsummed one waits
+// for it instead of holding another tally
+class OrderedTallyReduction {
+ public:
+  // window tallies per worker thread, lets a slow item fall a few behind
+  // before the other threads wait on it
+  static constexpr size_t WINDOW_PER_THREAD = 4;
+
+  OrderedTallyReduction(uint64_t n_items, size_t n_cells, size_t window);
+
+  // claims the next item and its cleared tally, false once every item is
+  // claimed or after Abort
+  bool Next(uint64_t& item, TransportTally*& tally);
+
+  // item's tally is filled, sums it and any ready items after it
+  void Finish(uint64_t item);
+
+  // stops handing out items and wakes waiting threads, for a failed worker
+  void Abort();
+
+  size_t GetWindow() const { return slots_.size(); }
+
+  // most items claimed but not yet summed at any one time
+  uint64_t GetPeakPending() const { return peak_pending_; }
+
+  // every item summed in order, once all are finished
+  TransportTally TakeResult() { return std::move(result_); }
+
+ private:
+  // on its own cache lines, threads filling neighbouring slots do not share
+  // the counts
+  struct alignas(CACHE_LINE_BYTES) Slot {
+    TransportTally tally;
+  };
+
+  std::mutex mutex_;
+  std::condition_variable summed_;
+  // item i is filled in slots_[i % window]
+  std::vector<Slot> slots_;
+  std::vector<uint8_t> ready_;
+  TransportTally result_;
+  uint64_t n_items_;
+  uint64_t next_item_{0};
+  // items [0, n_summed_) are in result_
+  uint64_t n_summed_{0};
+  uint64_t peak_pending_{0};
+  // one thread sums at a time, outside the lock
+  bool summing_{false};
+  bool aborted_{false};
+};
+
+// ----------------------------------------------------------------------------
+// TransportProblem
+// ----------------------------------------------------------------------------
+
+struct TransportMaterial {
+  std::shared_ptr<const CEMaterial> material;
+  // atoms per barn cm, scales the material's per atom xs
+  double atom_density;
+
+  double GetTotalXS(double energy) const {
+    return atom_density * material->GetTotalXS(energy);
+  }
+};
+
+// max of every material's macroscopic total xs on the union of their
+// nuclide grids. each material is linear between union points, so the
+// interpolated maximum bounds every material at every energy
+class MajorantXS {
+ public:
+  // relative headroom over the tabulated maximum, covers rounding between
+  // the union grid and the nuclide grids
+  static constexpr double PADDING = 1e-9;
+
+  MajorantXS() = default;
+  explicit MajorantXS(std::span<const TransportMaterial> materials);
+
+  bool Empty() const { return energies_.empty(); }
+  const std::vector<double>& GetEnergies() const { return energies_; }
+
+  double GetXS(double energy) const;
+
+ private:
+  std::vector<double> energies_;
+  std::vector<double> xs_;
+};
+
+// how flights are sampled in a cell. surface tracking stops at every
+// boundary and needs the distance to it. delta tracking flies against the
+// majorant and only asks which cell holds the collision point, rejecting
+// collisions with probability 1 - local / majorant xs
+enum class TrackingMode : uint8_t {
+  SURFACE,
+  DELTA,
+};
+
+// read only description of a fixed source problem shared by every transport
+// thread. material cells with a negative material id are void
+class TransportProblem {
+ public:
+  // events a history may take before it is counted as lost. an event is one
+  // flight, whether it ends in a crossing, a real or virtual collision or a
+  // leak, so both drivers stop a history at the same point
+  static constexpr uint64_t DEFAULT_MAX_EVENTS = 1000000;
+
+  TransportProblem(const Geometry& geometry, SourceSampler source);
+
+  // drops the majorant, BuildMajorant again once the materials are set
+  void SetMaterial(int material_id, std::shared_ptr<const CEMaterial> material,
+                   double atom_density);
+
+  // mode of every cell, clearing any set per cell
+  void SetTracking(TrackingMode mode) {
+    default_tracking_ = mode;
+    cell_tracking_.clear();
+  }
+
+  // mode of one material cell, mixing modes tracks some cells by surface
+  // and the rest by delta
+  void SetCellTracking(uint32_t cell, TrackingMode mode);
+
+  TrackingMode GetTracking(uint32_t cell) const {
+    return cell < cell_tracking_.size() ? cell_tracking_[cell]
+                                        : default_tracking_;
+  }
+
+  bool UsesDeltaTracking() const;
+
+  // throws on 0, a history needs at least its first flight
+  void SetMaxEvents(uint64_t max_events);
+  uint64_t GetMaxEvents() const { return max_events_; }
+
+  // counts the next flight of a history that has taken events so far, false
+  // once it is past the limit and the history is lost
+  bool CountEvent(uint64_t& events) const { return ++events <= max_events_; }
+
+  // majorant over the current materials, needed by delta tracking
+  void BuildMajorant();
+  const MajorantXS& GetMajorant() const { return majorant_; }
+
+  // throws unless the geometry is finalized, every non void material cell
+  // has a material, and delta tracking has a majorant
+  void Validate() const;
+
+  const Geometry& GetGeometry() const { return geometry_; }
+
+  SourceSite SampleSource(TransportRNG& rng) const { return source_(rng); }
+
+  // null for void
+  const TransportMaterial* GetMaterial(int material_id) const {
+    if (material_id < 0 ||
+        static_cast<size_t>(material_id) >= materials_.size()) {
+      return nullptr;
+    }
+    const TransportMaterial& material = materials_[material_id];
+    return material.material ? &material : nullptr;
+  }
+
+ private:
+  const Geometry& geometry_;
+  SourceSampler source_;
+  // indexed by material id
+  std::vector<TransportMaterial> materials_;
+  TrackingMode default_tracking_{TrackingMode::SURFACE};
+  // indexed by cell, empty until a cell gets its own mode
+  std::vector<TrackingMode> cell_tracking_;
+  MajorantXS majorant_;
+  uint64_t max_events_{DEFAULT_MAX_EVENTS};
+};
+
+}  // namespace charmander
+
+#endif  // CHARMANDER_TRANSPORT_TRANSPORT_H_
@@ -0,0 +1,129 @@
+#include "geometry/bounding_box.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "basic_types.h"
+#include "constants.h"
+#include "geometry/surface_table.h"
+
+namespace charmander {
+
+namespace {
+// widens cylinder and general plane extents so rounding in their sense tests
+// can never put an inside point outside the box
+constexpr double BOX_PAD = 1e-10;
+
+void BoundAxis(BoundingBox& box, int axis, double lower, double upper) {
+  double* bounds[3][2] = {{&box.x_min, &box.x_max},
+                          {&box.y_min, &box.y_max},
+                          {&box.z_min, &box.z_max}};
+  *bounds[axis][0] = std::max(*bounds[axis][0], lower);
+  *bounds[axis][1] = std::min(*bounds[axis][1], upper);
+}
+
+void BoundPlane(BoundingBox& box, int axis, double x0, bool positive) {
+  if (positive) {
+    BoundAxis(box, axis, x0, INF);
+  } else {
+    BoundAxis(box, axis, -INF, x0);
+  }
+}
+
+void BoundCylinder(BoundingBox& box, int axis, double r, double center) {
+  const double pad = BOX_PAD * (1.0 + r + std::abs(center));
+  BoundAxis(box, axis, center - r - pad, center + r + pad);
+}
+}  // namespace
+
+bool BoundingBox::Intersects(const Point& p, const Direction& d,
+                             double t_max) const {
+  const double origin[3] = {p.x, p.y, p.z};
+  const double direction[3] = {d.x, d.y, d.z};
+  const double lower[3] = {x_min, y_min, z_min};
+  const double upper[3] = {x_max, y_max, z_max};
+
+  double t_enter = 0.0;
+  double t_exit = t_max;
+  for (int axis = 0; axis < 3; ++axis) {
+    if (direction[axis] == 0.0) {
+      if (origin[axis] < lower[axis] || origin[axis] > upper[axis]) {
+        return false;
+      }
+      continue;
+    }
+    const double inv = 1.0 / direction[axis];
+    double t0 = (lower[axis] - origin[axis]) * inv;
+    double t1 = (upper[axis] - origin[axis]) * inv;
+    if (t0 > t1) std::swap(t0, t1);
+    t_enter = std::max(t_enter, t0);
+    t_exit = std::min(t_exit, t1);
+    if (t_enter > t_exit) return false;
+  }
+  return true;
+}
+
+BoundingBox HalfspaceBounds(const SurfaceData& surface, bool positive) {
+  BoundingBox box;
+  const auto& c = surface.coeffs;
+  switch (surface.type) {
+    case SurfaceType::X_PLANE:
+      BoundPlane(box, 0, c[0], positive);
+      break;
+    case SurfaceType::Y_PLANE:
+      BoundPlane(box, 1, c[0], positive);
+      break;
+    case SurfaceType::Z_PLANE:
+      BoundPlane(box, 2, c[0], positive);
+      break;
+    case SurfaceType::PLANE: {
+      // only a plane normal to one axis bounds that axis
+      int axis = -1;
+      int nonzero = 0;
+      for (int i = 0; i < 3; ++i) {
+        if (c[i] != 0.0) {
+          axis = i;
+          ++nonzero;
+        }
+      }
+      if (nonzero == 1) {
+        // a x >= d flips when a is negative, padded for rounding in a x - d
+        const double x0 = c[3] / c[axis];
+        const double pad = BOX_PAD * (1.0 + std::abs(x0));
+        if (positive == (c[axis] > 0.0)) {
+          BoundPlane(box, axis, x0 - pad, true);
+        } else {
+          BoundPlane(box, axis, x0 + pad, false);
+        }
+      }
+      break;
+    }
+    case SurfaceType::CYLINDER: {
+      if (positive) break;
+      // an infinite cylinder is bounded along every axis normal to its own
+      const double r = std::sqrt(c[0]);
+      for (int i = 0; i < 3; ++i) {
+        if (c[1 + i] == 0.0) BoundCylinder(box, i, r, c[4 + i]);
+      }
+      break;
+    }
+    case SurfaceType::X_CYLINDER:
+      if (positive) break;
+      BoundCylinder(box, 1, std::sqrt(c[0]), c[1]);
+      BoundCylinder(box, 2, std::sqrt(c[0]), c[2]);
+      break;
+    case SurfaceType::Y_CYLINDER:
+      if (positive) break;
+      BoundCylinder(box, 0, std::sqrt(c[0]), c[1]);
+      BoundCylinder(box, 2, std::sqrt(c[0]), c[2]);
+      break;
+    case SurfaceType::Z_CYLINDER:
+      if (positive) break;
+      BoundCylinder(box, 0, std::sqrt(c[0]), c[1]);
+      BoundCylinder(box, 1, std::sqrt(c[0]), c[2]);
+      break;
+  }
+  return box;
+}
+
+}  // namespace charmander
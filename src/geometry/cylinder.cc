@@ -5,13 +5,13 @@
 
 namespace charmander {
 Cylinder::Cylinder(double r, Direction axis, Point center)
-    : r_(r), axis_(normalize(axis)), p0_(center) {}
+    : r_(r), r2_(r * r), axis_(normalize(axis)), p0_(center) {}
 
 double Cylinder::Evaluate(Point p) const {
   Direction w = p - p0_;
   double wu = w * axis_;
   Direction wperp = w - wu * axis_;
-  return wperp * wperp - r_ * r_;
+  return wperp * wperp - r2_;
 }
 
 Direction Cylinder::Normal(Point p) const {
@@ -31,21 +31,49 @@ double Cylinder::Distance(Point p, Direction d) const {
 
   double A = dperp * dperp;
   double B = 2 * wperp * dperp;
-  double C = wperp * wperp - r_ * r_;
+  double C = wperp * wperp - r2_;
 
-  if (std::abs(A) < FP_TOLERANCE) return INF;
+  return QuadraticSurfaceDistance(A, B, C);
+}
+
+SurfaceData Cylinder::Pack() const {
+  return {SurfaceType::CYLINDER,
+          {r2_, axis_.x, axis_.y, axis_.z, p0_.x, p0_.y, p0_.z}};
+}
+
+double XCylinder::Evaluate(Point p) const {
+  return AxisCylinderEvaluate(p.y, p.z, r2_, p0_.y, p0_.z);
+}
+
+Direction XCylinder::Normal(Point p) const {
+  return normalize({0.0, p.y - p0_.y, p.z - p0_.z});
+}
+
+double XCylinder::Distance(Point p, Direction d) const {
+  return AxisCylinderDistance(p.y, p.z, d.y, d.z, r2_, p0_.y, p0_.z);
+}
+
+double YCylinder::Evaluate(Point p) const {
+  return AxisCylinderEvaluate(p.x, p.z, r2_, p0_.x, p0_.z);
+}
+
+Direction YCylinder::Normal(Point p) const {
+  return normalize({p.x - p0_.x, 0.0, p.z - p0_.z});
+}
 
-  double discriminant = B * B - 4 * A * C;
+double YCylinder::Distance(Point p, Direction d) const {
+  return AxisCylinderDistance(p.x, p.z, d.x, d.z, r2_, p0_.x, p0_.z);
+}
 
-  if (discriminant < 0.0) return INF;
+double ZCylinder::Evaluate(Point p) const {
+  return AxisCylinderEvaluate(p.x, p.y, r2_, p0_.x, p0_.y);
+}
 
-  double sqrt_disc = std::sqrt(discriminant);
-  double r1 = (-B - sqrt_disc) / (2 * A);
-  double r2 = (-B + sqrt_disc) / (2 * A);
+Direction ZCylinder::Normal(Point p) const {
+  return normalize({p.x - p0_.x, p.y - p0_.y, 0.0});
+}
 
-  double distance = INF;
-  if (r1 > COINCIDENT_SURF) distance = r1;
-  if (r2 > COINCIDENT_SURF && r2 < distance) distance = r2;
-  return distance;
+double ZCylinder::Distance(Point p, Direction d) const {
+  return AxisCylinderDistance(p.x, p.y, d.x, d.y, r2_, p0_.x, p0_.y);
 }
 }  // namespace charmander
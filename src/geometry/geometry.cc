@@ -1,7 +1,249 @@
 #include "geometry/geometry.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "basic_types.h"
+#include "constants.h"
+
 namespace charmander {
 
-Geometry::Geometry() {}
+namespace {
+// nesting deeper than this is taken as a universe filling itself
+constexpr size_t MAX_UNIVERSE_DEPTH = 32;
+}  // namespace
+
+Geometry::Geometry()
+    : surfaces_(std::make_shared<SurfaceTable>()), universes_(1) {}
+
+uint32_t Geometry::AddUniverse() {
+  universes_.emplace_back();
+  finalized_ = false;
+  return static_cast<uint32_t>(universes_.size() - 1);
+}
+
+uint32_t Geometry::AddLattice(Lattice lattice) {
+  lattices_.push_back(std::move(lattice));
+  finalized_ = false;
+  return static_cast<uint32_t>(lattices_.size() - 1);
+}
+
+size_t Geometry::AddCell(Region region, int material_id) {
+  return AddCell(ROOT_UNIVERSE, std::move(region), material_id);
+}
+
+size_t Geometry::AddCell(uint32_t universe, Region region, int material_id) {
+  if (universe >= universes_.size()) {
+    throw std::runtime_error("no universe " + std::to_string(universe));
+  }
+  region.ShareSurfaceTable(surfaces_);
+  cells_.push_back({std::move(region), material_id});
+  cells_.back().universe = universe;
+  universes_[universe].AddCell(static_cast<uint32_t>(cells_.size() - 1));
+  finalized_ = false;
+  return cells_.size() - 1;
+}
+
+size_t Geometry::AddFilledCell(uint32_t universe, Region region, FillType fill,
+                               uint32_t fill_index) {
+  const size_t cell = AddCell(universe, std::move(region), -1);
+  cells_[cell].fill = fill;
+  cells_[cell].fill_index = fill_index;
+  return cell;
+}
+
+void Geometry::Finalize() {
+  for (const Cell& cell : cells_) {
+    if (cell.fill == FillType::UNIVERSE &&
+        cell.fill_index >= universes_.size()) {
+      throw std::runtime_error("cell filled by missing universe " +
+                               std::to_string(cell.fill_index));
+    }
+    if (cell.fill == FillType::LATTICE && cell.fill_index >= lattices_.size()) {
+      throw std::runtime_error("cell filled by missing lattice " +
+                               std::to_string(cell.fill_index));
+    }
+  }
+  for (const Lattice& lattice : lattices_) {
+    for (uint32_t universe : lattice.GetUniverses()) {
+      if (universe >= universes_.size()) {
+        throw std::runtime_error("lattice filled by missing universe " +
+                                 std::to_string(universe));
+      }
+    }
+  }
+
+  for (Universe& universe : universes_) universe.Finalize(cells_);
+
+  // the address index is only needed while cells are added
+  surfaces_->ReleaseIndex();
+  neighbors_ = std::vector<NeighborList>(2 * surfaces_->Size());
+  finalized_ = true;
+}
+
+std::optional<size_t> Geometry::FindCell(const Point& p) const {
+  auto location = Locate(p);
+  if (!location) return std::nullopt;
+  return location->GetCell();
+}
+
+std::optional<GeometryLocation> Geometry::Locate(const Point& p) const {
+  GeometryLocation location;
+  if (!Locate(p, location)) return std::nullopt;
+  return location;
+}
+
+bool Geometry::Locate(const Point& p, GeometryLocation& location) const {
+  if (!finalized_) {
+    throw std::runtime_error("geometry must be finalized before cell search");
+  }
+
+  // clearing keeps the capacity, relocating does not allocate
+  location.levels.clear();
+  auto cell = universes_[ROOT_UNIVERSE].FindCell(cells_, p);
+  if (!cell) return false;
+  location.levels.push_back({*cell, -1, -1, Vec3(p)});
+  return Descend(location);
+}
+
+bool Geometry::Descend(GeometryLocation& location) const {
+  while (location.levels.size() < MAX_UNIVERSE_DEPTH) {
+    const GeometryLevel& level = location.levels.back();
+    const Cell& cell = cells_[level.cell];
+    // Point is immutable, lattice fills translate these instead
+    double x = level.local.x;
+    double y = level.local.y;
+    const double z = level.local.z;
+    uint32_t universe = 0;
+    int32_t lattice = -1;
+    int32_t element = -1;
+    switch (cell.fill) {
+      case FillType::MATERIAL:
+        return true;
+      case FillType::UNIVERSE:
+        universe = cell.fill_index;
+        break;
+      case FillType::LATTICE: {
+        const Lattice& fill = lattices_[cell.fill_index];
+        auto fill_element = fill.GetElement(x, y);
+        if (!fill_element) return false;
+        const auto [center_x, center_y] = fill.GetCenter(*fill_element);
+        x -= center_x;
+        y -= center_y;
+        universe = fill.GetUniverse(*fill_element);
+        lattice = static_cast<int32_t>(cell.fill_index);
+        element = static_cast<int32_t>(*fill_element);
+        break;
+      }
+    }
+
+    const Point local(x, y, z);
+    auto found = universes_[universe].FindCell(cells_, local);
+    if (!found) return false;
+    location.levels.push_back({*found, lattice, element, Vec3(local)});
+  }
+  throw std::runtime_error("universes nested deeper than " +
+                           std::to_string(MAX_UNIVERSE_DEPTH) + " levels");
+}
+
+GeometryCrossing Geometry::NextCrossing(const GeometryLocation& location,
+                                        const Direction& d) const {
+  GeometryCrossing nearest;
+  for (size_t k = 0; k < location.levels.size(); ++k) {
+    const GeometryLevel& level = location.levels[k];
+    const Region& region = cells_[level.cell].region;
+    const BoundaryCrossing crossing =
+        region.NextCrossing(level.local.ToPoint(), d);
+    if (crossing.distance < nearest.boundary.distance) {
+      nearest = {crossing, static_cast<uint32_t>(k)};
+    }
+    if (level.lattice >= 0) {
+      const Lattice& lattice = lattices_[level.lattice];
+      const double distance = lattice.ElementDistance(level.local.ToPoint(), d);
+      if (distance < nearest.boundary.distance) {
+        nearest = {{distance, nullptr, 0, false}, static_cast<uint32_t>(k)};
+      }
+    }
+  }
+  return nearest;
+}
+
+bool Geometry::Cross(GeometryLocation& location,
+                     const GeometryCrossing& crossing, const Point& p) const {
+  auto& levels = location.levels;
+  const uint32_t k = crossing.level;
+  const Vec3 root = levels[0].local;
+  // p in the coordinates of level j before level j is moved, lattices only
+  // translate
+  auto local = [&](uint32_t j) {
+    const Vec3& level = levels[j].local;
+    return Vec3(p.x - (root.x - level.x), p.y - (root.y - level.y), p.z);
+  };
+  // whether level j's lattice element still holds p, once level j - 1 has
+  // been moved
+  auto same_element = [&](uint32_t j) {
+    if (j == 0 || levels[j].lattice < 0) return true;
+    const Vec3& parent = levels[j - 1].local;
+    auto element = lattices_[levels[j].lattice].GetElement(parent.x, parent.y);
+    return element && static_cast<int32_t>(*element) == levels[j].element;
+  };
+
+  // levels above the crossing normally still hold, unless a coincident
+  // boundary was crossed at the same time
+  for (uint32_t j = 0; j < k; ++j) {
+    const Vec3 q = local(j);
+    if (!same_element(j) ||
+        !cells_[levels[j].cell].region.Contains(q.ToPoint())) {
+      return Locate(p, location);
+    }
+    levels[j].local = q;
+  }
+
+  // left a lattice element, search the lattice again from the cell it fills
+  if (!crossing.boundary.surface) {
+    if (k == 0 || levels[k].lattice < 0) return Locate(p, location);
+    levels.resize(k);
+    return Descend(location) || Locate(p, location);
+  }
+
+  if (!same_element(k)) return Locate(p, location);
+  const Vec3 q = local(k);
+  const uint32_t universe = cells_[levels[k].cell].universe;
+  NeighborList& neighbors = GetNeighborList(crossing.boundary.surface_index,
+                                            crossing.boundary.sense);
+  std::optional<uint32_t> cell = neighbors.Find([&](uint32_t c) {
+    return cells_[c].universe == universe &&
+           cells_[c].region.Contains(q.ToPoint());
+  });
+  if (!cell) {
+    cell = universes_[universe].FindCell(cells_, q.ToPoint());
+    // nothing past the root boundary is outside the model
+    if (!cell) return k != 0 && Locate(p, location);
+    neighbors.Add(*cell);
+  }
+  // the crossed level keeps its lattice element, the levels below it are
+  // searched again in its storage
+  levels.resize(k + 1);
+  levels[k].cell = *cell;
+  levels[k].local = q;
+  return Descend(location) || Locate(p, location);
+}
+
+std::vector<uint32_t> Geometry::GetNeighbors(const Surface& surface,
+                                             bool sense) const {
+  // a linear scan, this is for inspection and not used while tracking
+  for (size_t i = 0; i < surfaces_->Size() && 2 * i < neighbors_.size(); ++i) {
+    if (&surfaces_->GetSurface(i) == &surface) {
+      return GetNeighborList(static_cast<uint32_t>(i), sense).GetCells();
+    }
+  }
+  return {};
+}
 
-}  // namespace charmander
\ No newline at end of file
+}  // namespace charmander
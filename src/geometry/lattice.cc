@@ -0,0 +1,141 @@
+#include "geometry/lattice.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "basic_types.h"
+#include "constants.h"
+#include "geometry/surface_table.h"
+
+namespace charmander {
+
+namespace {
+const double SQRT3 = std::sqrt(3.0);
+
+// hexagon side normals for flat sides facing +-x
+const double HEX_NORMALS[3][2] = {
+    {1.0, 0.0}, {0.5, 0.5 * SQRT3}, {-0.5, 0.5 * SQRT3}};
+
+// distance along a direction with component v from s to the slab
+// |s| <= half_width, leaving it
+double SlabExitDistance(double s, double v, double half_width) {
+  if (v > 0.0) return AxisPlaneDistance(s, v, half_width);
+  if (v < 0.0) return AxisPlaneDistance(s, v, -half_width);
+  return INF;
+}
+}  // namespace
+
+Lattice::Lattice(LatticeType type, double x0, double y0, double pitch_x,
+                 double pitch_y, size_t nx, size_t ny,
+                 std::vector<uint32_t> universes)
+    : type_(type),
+      x0_(x0),
+      y0_(y0),
+      pitch_x_(pitch_x),
+      pitch_y_(pitch_y),
+      nx_(nx),
+      ny_(ny),
+      universes_(std::move(universes)) {
+  if (pitch_x_ <= 0.0 || pitch_y_ <= 0.0) {
+    throw std::runtime_error("lattice pitch must be positive");
+  }
+  if (universes_.size() != nx_ * ny_) {
+    throw std::runtime_error("lattice needs " + std::to_string(nx_ * ny_) +
+                             " universes, got " +
+                             std::to_string(universes_.size()));
+  }
+}
+
+Lattice Lattice::Rectangular(double x0, double y0, double pitch_x,
+                             double pitch_y, size_t nx, size_t ny,
+                             std::vector<uint32_t> universes) {
+  return Lattice(LatticeType::RECTANGULAR, x0, y0, pitch_x, pitch_y, nx, ny,
+                 std::move(universes));
+}
+
+Lattice Lattice::Hexagonal(double x0, double y0, double pitch, size_t n_rings,
+                           std::vector<uint32_t> universes) {
+  if (n_rings == 0) throw std::runtime_error("hex lattice needs a ring");
+  const size_t width = 2 * n_rings - 1;
+  return Lattice(LatticeType::HEXAGONAL, x0, y0, pitch, pitch, width, width,
+                 std::move(universes));
+}
+
+std::optional<size_t> Lattice::GetElement(double x, double y) const {
+  switch (type_) {
+    case LatticeType::RECTANGULAR: {
+      const double i = std::floor((x - x0_) / pitch_x_);
+      const double j = std::floor((y - y0_) / pitch_y_);
+      if (i < 0.0 || j < 0.0 || i >= nx_ || j >= ny_) return std::nullopt;
+      return static_cast<size_t>(j) * nx_ + static_cast<size_t>(i);
+    }
+    case LatticeType::HEXAGONAL: {
+      // fractional axial coordinates, rounded to the nearest hexagon in cube
+      // coordinates
+      const double r = (y - y0_) / (0.5 * SQRT3 * pitch_x_);
+      const double q = (x - x0_) / pitch_x_ - 0.5 * r;
+      const double s = -q - r;
+      double rq = std::round(q);
+      double rr = std::round(r);
+      const double rs = std::round(s);
+      const double dq = std::abs(rq - q);
+      const double dr = std::abs(rr - r);
+      const double ds = std::abs(rs - s);
+      if (dq > dr && dq > ds) {
+        rq = -rr - rs;
+      } else if (dr > ds) {
+        rr = -rq - rs;
+      }
+
+      const double ring =
+          std::max({std::abs(rq), std::abs(rr), std::abs(rq + rr)});
+      const double n_rings = static_cast<double>((nx_ + 1) / 2);
+      if (ring >= n_rings) return std::nullopt;
+      return static_cast<size_t>(rr + n_rings - 1) * nx_ +
+             static_cast<size_t>(rq + n_rings - 1);
+    }
+  }
+  return std::nullopt;
+}
+
+std::pair<double, double> Lattice::GetCenter(size_t element) const {
+  const double i = static_cast<double>(element % nx_);
+  const double j = static_cast<double>(element / nx_);
+  switch (type_) {
+    case LatticeType::RECTANGULAR:
+      return {x0_ + (i + 0.5) * pitch_x_, y0_ + (j + 0.5) * pitch_y_};
+    case LatticeType::HEXAGONAL: {
+      const double n_rings = static_cast<double>((nx_ + 1) / 2);
+      const double q = i - (n_rings - 1);
+      const double r = j - (n_rings - 1);
+      return {x0_ + pitch_x_ * (q + 0.5 * r), y0_ + 0.5 * SQRT3 * pitch_x_ * r};
+    }
+  }
+  return {x0_, y0_};
+}
+
+double Lattice::ElementDistance(const Point& p, const Direction& d) const {
+  switch (type_) {
+    case LatticeType::RECTANGULAR:
+      return std::min(SlabExitDistance(p.x, d.x, 0.5 * pitch_x_),
+                      SlabExitDistance(p.y, d.y, 0.5 * pitch_y_));
+    case LatticeType::HEXAGONAL: {
+      double distance = INF;
+      for (const auto& n : HEX_NORMALS) {
+        const double s = p.x * n[0] + p.y * n[1];
+        const double v = d.x * n[0] + d.y * n[1];
+        distance = std::min(distance, SlabExitDistance(s, v, 0.5 * pitch_x_));
+      }
+      return distance;
+    }
+  }
+  return INF;
+}
+
+}  // namespace charmander
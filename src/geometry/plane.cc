@@ -7,13 +7,13 @@
 
 namespace charmander {
 Plane::Plane(double a, double b, double c, double d)
-    : Surface(), a_(a), b_(b), c_(c), d_(d) {};
+    : Surface(), a_(a), b_(b), c_(c), d_(d), n_(normalize({a, b, c})) {};
 
 double Plane::Evaluate(Point p) const {
   return a_ * p.x + b_ * p.y + c_ * p.z - d_;
 };
 
-Direction Plane::Normal(Point p) const { return normalize({a_, b_, c_}); };
+Direction Plane::Normal(Point) const { return n_; };
 
 double Plane::Distance(Point p, Direction d) const {
   double denominator = (d.x * a_ + d.y * b_ + d.z * c_);
@@ -22,4 +22,32 @@ double Plane::Distance(Point p, Direction d) const {
   double distance = -Evaluate(p) / denominator;
   return (distance > COINCIDENT_SURF) ? distance : INF;
 };
+
+SurfaceData Plane::Pack() const {
+  return {SurfaceType::PLANE, {a_, b_, c_, d_}};
+};
+
+double XPlane::Evaluate(Point p) const { return p.x - d_; };
+
+Direction XPlane::Normal(Point) const { return {1.0, 0.0, 0.0}; };
+
+double XPlane::Distance(Point p, Direction d) const {
+  return AxisPlaneDistance(p.x, d.x, d_);
+};
+
+double YPlane::Evaluate(Point p) const { return p.y - d_; };
+
+Direction YPlane::Normal(Point) const { return {0.0, 1.0, 0.0}; };
+
+double YPlane::Distance(Point p, Direction d) const {
+  return AxisPlaneDistance(p.y, d.y, d_);
+};
+
+double ZPlane::Evaluate(Point p) const { return p.z - d_; };
+
+Direction ZPlane::Normal(Point) const { return {0.0, 0.0, 1.0}; };
+
+double ZPlane::Distance(Point p, Direction d) const {
+  return AxisPlaneDistance(p.z, d.z, d_);
+};
 }  // namespace charmander
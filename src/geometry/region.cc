@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <cstdint>
+#include <memory>
 #include <stdexcept>
+#include <vector>
 
 #include "constants.h"
 #include "basic_types.h"
@@ -7,24 +11,309 @@
 
 namespace charmander
 {
-  Region::Region(std::vector<std::vector<Halfspace>> clauses): clauses_(std::move(clauses)) {
+  namespace
+  {
+    struct Crossing
+    {
+      double distance;
+      uint32_t surface;
+
+      // std heaps are max heaps, the nearest crossing goes on top
+      bool operator<(const Crossing& other) const {
+        return distance > other.distance;
+      }
+    };
+
+    // reused between calls so tracking does not allocate per step
+    struct DistanceScratch
+    {
+      std::vector<uint64_t> senses;
+      std::vector<uint32_t> unsatisfied;
+      std::vector<Crossing> crossings;
+    };
+
+    bool GetBit(const std::vector<uint64_t>& bits, size_t i) {
+      return (bits[i >> 6] >> (i & 63)) & 1;
+    }
+
+    // senses just past the start, so a particle sitting on a surface sees the
+    // side it is moving into, and every surface's nearest crossing. surfaces
+    // are numbered 0 to n_surfaces - 1, table_index(i) is surface i's entry
+    // in the table
+    template <typename TableIndex>
+    void InitCrossings(const SurfaceTable& surfaces, size_t n_surfaces,
+                       TableIndex&& table_index, const Point& p,
+                       const Direction& d, DistanceScratch& scratch)
+    {
+      const Point start = p + COINCIDENT_SURF * d;
+      scratch.senses.assign((n_surfaces + 63) / 64, 0);
+      scratch.crossings.clear();
+      for (size_t i = 0; i < n_surfaces; ++i)
+      {
+        const uint32_t t = table_index(i);
+        if (surfaces.Sense(t, start)) {
+          scratch.senses[i >> 6] |= uint64_t{1} << (i & 63);
+        }
+        const double dist = surfaces.Distance(t, p, d);
+        if (dist < INF) {
+          scratch.crossings.push_back({dist, static_cast<uint32_t>(i)});
+        }
+      }
+      std::make_heap(scratch.crossings.begin(), scratch.crossings.end());
+    }
+
+    // walks crossings nearest first, flipping one sense bit per crossing and
+    // calling flip(surface, new_sense). returns the first crossing at which
+    // inside() no longer matches start_in
+    template <typename TableIndex, typename Flip, typename Inside>
+    BoundaryCrossing WalkCrossings(const SurfaceTable& surfaces,
+                                   TableIndex&& table_index, const Point& p,
+                                   const Direction& d,
+                                   DistanceScratch& scratch, bool start_in,
+                                   Flip&& flip, Inside&& inside)
+    {
+      auto& senses = scratch.senses;
+      auto& crossings = scratch.crossings;
+      while (!crossings.empty())
+      {
+        const double dist = crossings.front().distance;
+        // at corners the nearest surface of the batch is reported
+        const uint32_t first = crossings.front().surface;
+        // crossings within COINCIDENT_SURF of each other (corners) are taken
+        // together, like evaluating the point just past them
+        while (!crossings.empty() &&
+               crossings.front().distance <= dist + COINCIDENT_SURF)
+        {
+          const Crossing crossing = crossings.front();
+          std::pop_heap(crossings.begin(), crossings.end());
+          crossings.pop_back();
+
+          const uint32_t i = crossing.surface;
+          senses[i >> 6] ^= uint64_t{1} << (i & 63);
+          flip(i, GetBit(senses, i));
+
+          // quadrics can be crossed again further along
+          const double next =
+              surfaces.Distance(table_index(i), p, d, crossing.distance);
+          if (next < INF) {
+            crossings.push_back({next, i});
+            std::push_heap(crossings.begin(), crossings.end());
+          }
+        }
+        // if start in want end in false (exit) if start out want end in (entry)
+        if (inside() != start_in)
+        {
+          const uint32_t t = table_index(first);
+          return {dist, &surfaces.GetSurface(t), t, GetBit(senses, first)};
+        }
+      }
+      return {};
+    }
+  } // namespace
+
+  Region::Region(std::vector<std::vector<Halfspace>> clauses) {
 
-    if (clauses_.empty()) {
+    if (clauses.empty()) {
       throw std::runtime_error("empty clauses vector");
     }
-    for (auto& clause : clauses_) {
+    for (auto& clause : clauses) {
       if (clause.empty()) {
         throw std::runtime_error("empty halfspace vector");
       }
     }
+
+    // a table of its own until added to a Geometry
+    auto surfaces = std::make_shared<SurfaceTable>();
+    clause_offsets_.reserve(clauses.size() + 1);
+    clause_offsets_.push_back(0);
+    for (const auto& clause : clauses) {
+      for (const auto& hs : clause) {
+        halfspaces_.push_back(
+            Encode(surfaces->Add(hs.GetSurface()), hs.IsPositive()));
+      }
+      clause_offsets_.push_back(static_cast<uint32_t>(halfspaces_.size()));
+    }
+    halfspaces_.shrink_to_fit();
+    surfaces->ReleaseIndex();
+    surfaces_ = std::move(surfaces);
+
+    BuildAcceleration();
+  }
+
+  void Region::ShareSurfaceTable(const std::shared_ptr<SurfaceTable>& table) {
+    if (!table) throw std::runtime_error("region needs a surface table");
+    if (table == surfaces_) return;
+    for (int32_t& hs : halfspaces_) {
+      hs = Encode(table->Add(surfaces_->GetSurface(DecodeIndex(hs))),
+                  DecodePositive(hs));
+    }
+    surfaces_ = table;
+    BuildAcceleration();
+  }
+
+  void Region::BuildAcceleration() {
+    surface_ids_.clear();
+    for (int32_t hs : halfspaces_) surface_ids_.push_back(DecodeIndex(hs));
+    std::sort(surface_ids_.begin(), surface_ids_.end());
+    surface_ids_.erase(std::unique(surface_ids_.begin(), surface_ids_.end()),
+                       surface_ids_.end());
+    surface_ids_.shrink_to_fit();
+    auto position = [&](int32_t hs) {
+      return static_cast<size_t>(std::lower_bound(surface_ids_.begin(),
+                                                  surface_ids_.end(),
+                                                  DecodeIndex(hs)) -
+                                 surface_ids_.begin());
+    };
+
+    const size_t n_surfaces = surface_ids_.size();
+    surface_use_offsets_.assign(n_surfaces + 1, 0);
+    for (int32_t hs : halfspaces_) ++surface_use_offsets_[position(hs) + 1];
+    for (size_t i = 0; i < n_surfaces; ++i) {
+      surface_use_offsets_[i + 1] += surface_use_offsets_[i];
+    }
+    surface_use_offsets_.shrink_to_fit();
+    surface_uses_.assign(surface_use_offsets_.back(), 0);
+    surface_uses_.shrink_to_fit();
+    std::vector<uint32_t> next(surface_use_offsets_.begin(),
+                               surface_use_offsets_.end() - 1);
+    for (size_t c = 0; c < GetNumClauses(); ++c) {
+      for (uint32_t h = clause_offsets_[c]; h < clause_offsets_[c + 1]; ++h) {
+        const int32_t hs = halfspaces_[h];
+        surface_uses_[next[position(hs)]++] =
+            Encode(static_cast<uint32_t>(c), DecodePositive(hs));
+      }
+    }
+
+    // a single clause's box would only repeat the region box
+    std::vector<BoundingBox> clause_boxes(GetNumClauses(), BoundingBox());
+    box_ = BoundingBox::Empty();
+    for (size_t c = 0; c < GetNumClauses(); ++c) {
+      for (uint32_t h = clause_offsets_[c]; h < clause_offsets_[c + 1]; ++h) {
+        const int32_t hs = halfspaces_[h];
+        clause_boxes[c] = IntersectBoxes(
+            clause_boxes[c],
+            HalfspaceBounds((*surfaces_)[DecodeIndex(hs)], DecodePositive(hs)));
+      }
+      box_ = UnionBoxes(box_, clause_boxes[c]);
+    }
+    if (clause_boxes.size() == 1) clause_boxes.clear();
+    clause_boxes.shrink_to_fit();
+    clause_boxes_ = std::move(clause_boxes);
+  }
+
+  std::vector<std::vector<Halfspace>> Region::GetClauses() const {
+    std::vector<std::vector<Halfspace>> clauses(GetNumClauses());
+    for (size_t c = 0; c < clauses.size(); ++c) {
+      clauses[c].reserve(clause_offsets_[c + 1] - clause_offsets_[c]);
+      for (uint32_t h = clause_offsets_[c]; h < clause_offsets_[c + 1]; ++h) {
+        clauses[c].emplace_back(
+            &surfaces_->GetSurface(DecodeIndex(halfspaces_[h])),
+            DecodePositive(halfspaces_[h]));
+      }
+    }
+    return clauses;
+  }
+
+  size_t Region::GetMemoryBytes() const {
+    return halfspaces_.capacity() * sizeof(int32_t) +
+           clause_offsets_.capacity() * sizeof(uint32_t) +
+           surface_ids_.capacity() * sizeof(uint32_t) +
+           surface_use_offsets_.capacity() * sizeof(uint32_t) +
+           surface_uses_.capacity() * sizeof(int32_t) +
+           clause_boxes_.capacity() * sizeof(BoundingBox);
+  }
+
+  void Region::Compile() {
+    // clauses as sets of halfspaces, sorted by surface then side
+    auto by_surface = [](int32_t a, int32_t b) {
+      const uint32_t ia = DecodeIndex(a);
+      const uint32_t ib = DecodeIndex(b);
+      return ia != ib ? ia < ib : a < b;
+    };
+    std::vector<std::vector<int32_t>> clauses;
+    for (size_t c = 0; c < GetNumClauses(); ++c) {
+      std::vector<int32_t> clause(halfspaces_.begin() + clause_offsets_[c],
+                                  halfspaces_.begin() + clause_offsets_[c + 1]);
+      std::sort(clause.begin(), clause.end(), by_surface);
+      clause.erase(std::unique(clause.begin(), clause.end()), clause.end());
+
+      // both sides of one surface, the clause holds nowhere
+      bool contradiction = false;
+      for (size_t h = 1; h < clause.size(); ++h) {
+        if (DecodeIndex(clause[h]) == DecodeIndex(clause[h - 1])) {
+          contradiction = true;
+        }
+      }
+      if (!contradiction) clauses.push_back(std::move(clause));
+    }
+
+    // nothing holds anywhere, keep a single contradiction
+    if (clauses.empty()) {
+      clauses.push_back({halfspaces_.front(), -halfspaces_.front()});
+    }
+
+    // a clause containing every halfspace of another only holds where the
+    // smaller one already does
+    std::stable_sort(clauses.begin(), clauses.end(),
+                     [](const auto& a, const auto& b) {
+                       return a.size() < b.size();
+                     });
+    std::vector<std::vector<int32_t>> kept;
+    for (auto& clause : clauses) {
+      bool absorbed = false;
+      for (const auto& smaller : kept) {
+        if (std::includes(clause.begin(), clause.end(), smaller.begin(),
+                          smaller.end(), by_surface)) {
+          absorbed = true;
+          break;
+        }
+      }
+      if (!absorbed) kept.push_back(std::move(clause));
+    }
+
+    // cheap tests first within a clause, cheap clauses first overall
+    auto cost = [&](int32_t hs) {
+      return SurfaceCost((*surfaces_)[DecodeIndex(hs)].type);
+    };
+    for (auto& clause : kept) {
+      std::stable_sort(clause.begin(), clause.end(),
+                       [&](int32_t a, int32_t b) { return cost(a) < cost(b); });
+    }
+    std::stable_sort(kept.begin(), kept.end(),
+                     [&](const auto& a, const auto& b) {
+                       int cost_a = 0;
+                       int cost_b = 0;
+                       for (int32_t hs : a) cost_a += cost(hs);
+                       for (int32_t hs : b) cost_b += cost(hs);
+                       return cost_a < cost_b;
+                     });
+
+    // rebuild the flat storage, surfaces no longer used drop out of
+    // surface_ids_
+    std::vector<int32_t> halfspaces;
+    std::vector<uint32_t> clause_offsets{0};
+    for (const auto& clause : kept) {
+      halfspaces.insert(halfspaces.end(), clause.begin(), clause.end());
+      clause_offsets.push_back(static_cast<uint32_t>(halfspaces.size()));
+    }
+    halfspaces.shrink_to_fit();
+
+    halfspaces_ = std::move(halfspaces);
+    clause_offsets_ = std::move(clause_offsets);
+    BuildAcceleration();
   }
 
   bool Region::Contains(const Point& p) const {
-    for (const auto& clause : clauses_) {
+    if (!box_.Contains(p)) return false;
+    const size_t n_clauses = GetNumClauses();
+    for (size_t c = 0; c < n_clauses; ++c) {
+      // a single clause's box is the region box already checked
+      if (n_clauses > 1 && !clause_boxes_[c].Contains(p)) continue;
       bool inclause = true;
-      for (const auto& hs : clause)
+      for (uint32_t h = clause_offsets_[c]; h < clause_offsets_[c + 1]; ++h)
       {
-        if (!hs.Sense(p)) {
+        const int32_t hs = halfspaces_[h];
+        if (surfaces_->Sense(DecodeIndex(hs), p) != DecodePositive(hs)) {
           inclause = false;
           break;
         }
@@ -34,23 +323,171 @@ namespace charmander
     return false;
   }
 
-  double Region::Distance(const Point& p, const Direction& d) const
+  BoundaryCrossing Region::NextCrossing(const Point& p,
+                                        const Direction& d) const
   {
-    const bool start_in = Contains(p);
-    double min_dist = INF;
-    for (const auto& clause : clauses_)
+    // starting outside the box and never reaching it, never inside
+    if (!box_.Contains(p) && !box_.Intersects(p, d)) return {};
+
+    const SurfaceTable& surfaces = *surfaces_;
+    auto table_index = [&](size_t i) { return surface_ids_[i]; };
+    thread_local DistanceScratch scratch;
+    InitCrossings(surfaces, surface_ids_.size(), table_index, p, d, scratch);
+
+    // a clause holds while none of its halfspaces disagree with the senses
+    const size_t n_clauses = GetNumClauses();
+    auto& unsatisfied = scratch.unsatisfied;
+    unsatisfied.assign(n_clauses, 0);
+    for (size_t i = 0; i < surface_ids_.size(); ++i)
     {
-      for (const auto& hs : clause)
+      const bool sense = GetBit(scratch.senses, i);
+      for (uint32_t u = surface_use_offsets_[i];
+           u < surface_use_offsets_[i + 1]; ++u)
       {
-        const double dist = hs.GetSurface().Distance(p, d);
-        // dont care
-        if (dist >= min_dist) continue;
-        // check if we end in the region or not
-        const bool end_in = Contains(p + (dist + COINCIDENT_SURF) * d);
-        // if start in want end in false (exit) if start out want end in (entry)
-        if (end_in != start_in) min_dist = dist;
+        const int32_t use = surface_uses_[u];
+        if (sense != DecodePositive(use)) ++unsatisfied[DecodeIndex(use)];
+      }
+    }
+    size_t satisfied = 0;
+    for (size_t c = 0; c < n_clauses; ++c)
+    {
+      if (unsatisfied[c] == 0) ++satisfied;
+    }
+
+    auto flip = [&](uint32_t i, bool sense) {
+      for (uint32_t u = surface_use_offsets_[i];
+           u < surface_use_offsets_[i + 1]; ++u)
+      {
+        const int32_t use = surface_uses_[u];
+        const uint32_t clause = DecodeIndex(use);
+        if (sense == DecodePositive(use)) {
+          if (--unsatisfied[clause] == 0) ++satisfied;
+        } else {
+          if (unsatisfied[clause]++ == 0) --satisfied;
+        }
       }
+    };
+    return WalkCrossings(surfaces, table_index, p, d, scratch, satisfied > 0,
+                         flip, [&] { return satisfied > 0; });
+  }
+
+  CSGRegion::CSGRegion(const Halfspace& hs) {
+    nodes_.push_back(
+        {Op::HALFSPACE, hs.IsPositive(), surfaces_.Add(hs.GetSurface())});
+    box_ = ComputeBoundingBox();
+  }
+
+  CSGRegion::CSGRegion(const Region& region) {
+    // or of the clauses, each an and of its halfspaces. children come first,
+    // the previous subtree root becomes the left child
+    uint32_t region_root = 0;
+    const auto& clauses = region.GetClauses();
+    for (size_t c = 0; c < clauses.size(); ++c) {
+      uint32_t clause_root = 0;
+      for (size_t h = 0; h < clauses[c].size(); ++h) {
+        const Halfspace& hs = clauses[c][h];
+        nodes_.push_back(
+            {Op::HALFSPACE, hs.IsPositive(), surfaces_.Add(hs.GetSurface())});
+        if (h > 0) {
+          nodes_[clause_root].parent = static_cast<uint32_t>(nodes_.size());
+          nodes_.push_back({Op::AND, false, clause_root});
+        }
+        clause_root = static_cast<uint32_t>(nodes_.size() - 1);
+      }
+      if (c > 0) {
+        nodes_[region_root].parent = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back({Op::OR, false, region_root});
+      }
+      region_root = static_cast<uint32_t>(nodes_.size() - 1);
     }
-    return min_dist;
+    box_ = region.GetBoundingBox();
+  }
+
+  CSGRegion CSGRegion::Combine(Op op, const CSGRegion& lhs,
+                               const CSGRegion& rhs) {
+    CSGRegion result = lhs;
+    const uint32_t offset = static_cast<uint32_t>(lhs.nodes_.size());
+    result.nodes_.reserve(lhs.nodes_.size() + rhs.nodes_.size() + 1);
+    for (Node node : rhs.nodes_) {
+      node.index =
+          (node.op == Op::HALFSPACE)
+              ? result.surfaces_.Add(rhs.surfaces_.GetSurface(node.index))
+              : node.index + offset;
+      if (node.parent != NO_PARENT) node.parent += offset;
+      result.nodes_.push_back(node);
+    }
+    result.nodes_[offset - 1].parent =
+        static_cast<uint32_t>(result.nodes_.size());
+    result.nodes_.push_back({op, false, offset - 1});
+    result.box_ = (op == Op::AND) ? IntersectBoxes(lhs.box_, rhs.box_)
+                                  : UnionBoxes(lhs.box_, rhs.box_);
+    return result;
+  }
+
+  BoundingBox CSGRegion::ComputeBoundingBox() const {
+    // postfix order, an operator's operands are the top two boxes
+    std::vector<BoundingBox> stack;
+    for (const Node& node : nodes_) {
+      if (node.op == Op::HALFSPACE) {
+        stack.push_back(HalfspaceBounds(surfaces_[node.index], node.positive));
+        continue;
+      }
+      const BoundingBox right = stack.back();
+      stack.pop_back();
+      stack.back() = (node.op == Op::AND) ? IntersectBoxes(stack.back(), right)
+                                          : UnionBoxes(stack.back(), right);
+    }
+    return stack.back();
+  }
+
+  template <typename Sense>
+  bool CSGRegion::Evaluate(const Sense& sense) const {
+    // values of finished left operands waiting on their right subtree
+    thread_local std::vector<uint8_t> stack;
+    stack.clear();
+    const uint32_t root = GetRoot();
+    uint32_t i = 0;
+    while (true) {
+      const Node& node = nodes_[i];
+      bool value;
+      if (node.op == Op::HALFSPACE) {
+        value = sense(node.index) == node.positive;
+      } else {
+        const bool right = stack.back();
+        stack.pop_back();
+        const bool left = stack.back();
+        stack.pop_back();
+        value = (node.op == Op::AND) ? (left && right) : (left || right);
+      }
+      // a false left operand settles an and, a true one an or, their value is
+      // the operator's and the right subtree in between is skipped
+      while (nodes_[i].parent != NO_PARENT &&
+             value == (nodes_[nodes_[i].parent].op == Op::OR)) {
+        i = nodes_[i].parent;
+      }
+      if (i == root) return value;
+      stack.push_back(value);
+      ++i;
+    }
+  }
+
+  bool CSGRegion::Contains(const Point& p) const {
+    if (!box_.Contains(p)) return false;
+    return Evaluate([&](uint32_t i) { return surfaces_.Sense(i, p); });
+  }
+
+  BoundaryCrossing CSGRegion::NextCrossing(const Point& p,
+                                           const Direction& d) const
+  {
+    if (!box_.Contains(p) && !box_.Intersects(p, d)) return {};
+
+    auto table_index = [](size_t i) { return static_cast<uint32_t>(i); };
+    thread_local DistanceScratch scratch;
+    InitCrossings(surfaces_, surfaces_.Size(), table_index, p, d, scratch);
+    auto inside = [&] {
+      return Evaluate([&](uint32_t i) { return GetBit(scratch.senses, i); });
+    };
+    return WalkCrossings(surfaces_, table_index, p, d, scratch, inside(),
+                         [](uint32_t, bool) {}, inside);
   }
 } // namespace charmander
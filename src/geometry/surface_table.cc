@@ -0,0 +1,38 @@
+#include "geometry/surface_table.h"
+
+#include <cstdint>
+
+#include "geometry/surface.h"
+
+namespace charmander {
+
+uint32_t SurfaceTable::Add(const Surface& surface) {
+  if (index_.empty()) {
+    for (size_t i = 0; i < sources_.size(); ++i) {
+      index_.emplace(sources_[i], static_cast<uint32_t>(i));
+    }
+  }
+  auto [it, inserted] =
+      index_.try_emplace(&surface, static_cast<uint32_t>(surfaces_.size()));
+  if (inserted) {
+    surfaces_.push_back(surface.Pack());
+    sources_.push_back(&surface);
+  }
+  return it->second;
+}
+
+void SurfaceTable::ReleaseIndex() {
+  std::unordered_map<const Surface*, uint32_t>().swap(index_);
+  surfaces_.shrink_to_fit();
+  sources_.shrink_to_fit();
+}
+
+size_t SurfaceTable::GetMemoryBytes() const {
+  return surfaces_.capacity() * sizeof(SurfaceData) +
+         sources_.capacity() * sizeof(const Surface*) +
+         index_.bucket_count() * sizeof(void*) +
+         index_.size() * (sizeof(const Surface*) + sizeof(uint32_t) +
+                          2 * sizeof(void*));
+}
+
+}  // namespace charmander
@@ -0,0 +1,136 @@
+#include "geometry/universe.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "basic_types.h"
+#include "constants.h"
+
+namespace charmander {
+
+namespace {
+// cells per bvh leaf
+constexpr size_t BVH_LEAF_SIZE = 4;
+
+// midpoint of a possibly half open interval, used to sort cells spatially
+double Centroid(double lower, double upper) {
+  if (std::isfinite(lower) && std::isfinite(upper)) {
+    return 0.5 * (lower + upper);
+  }
+  if (std::isfinite(lower)) return lower;
+  if (std::isfinite(upper)) return upper;
+  return 0.0;
+}
+
+bool HasAnyBound(const BoundingBox& box) {
+  return std::isfinite(box.x_min) || std::isfinite(box.x_max) ||
+         std::isfinite(box.y_min) || std::isfinite(box.y_max) ||
+         std::isfinite(box.z_min) || std::isfinite(box.z_max);
+}
+
+double Coordinate(const Point& p, int axis) {
+  return axis == 0 ? p.x : (axis == 1 ? p.y : p.z);
+}
+}  // namespace
+
+void Universe::Finalize(const std::vector<Cell>& cells) {
+  bvh_nodes_.clear();
+  bvh_cells_.clear();
+  unbounded_cells_.clear();
+
+  std::vector<uint32_t> bounded;
+  std::vector<BoundingBox> boxes;
+  std::vector<Point> centroids;
+  for (uint32_t cell : cells_) {
+    const BoundingBox& box = cells[cell].region.GetBoundingBox();
+    if (!HasAnyBound(box)) {
+      unbounded_cells_.push_back(cell);
+      continue;
+    }
+    bvh_cells_.push_back(static_cast<uint32_t>(bounded.size()));
+    bounded.push_back(cell);
+    boxes.push_back(box);
+    centroids.emplace_back(Centroid(box.x_min, box.x_max),
+                           Centroid(box.y_min, box.y_max),
+                           Centroid(box.z_min, box.z_max));
+  }
+
+  if (!bvh_cells_.empty()) {
+    bvh_nodes_.reserve(2 * bvh_cells_.size() / BVH_LEAF_SIZE + 1);
+    BuildBVH(0, bvh_cells_.size(), boxes, centroids);
+  }
+  for (uint32_t& cell : bvh_cells_) cell = bounded[cell];
+  bvh_nodes_.shrink_to_fit();
+  finalized_ = true;
+}
+
+uint32_t Universe::BuildBVH(size_t begin, size_t end,
+                            const std::vector<BoundingBox>& boxes,
+                            const std::vector<Point>& centroids) {
+  const uint32_t node = static_cast<uint32_t>(bvh_nodes_.size());
+  bvh_nodes_.push_back({BoundingBox::Empty(), 0, 0});
+
+  BoundingBox box = BoundingBox::Empty();
+  BoundingBox centroid_box = BoundingBox::Empty();
+  for (size_t i = begin; i < end; ++i) {
+    box = UnionBoxes(box, boxes[bvh_cells_[i]]);
+    const Point& c = centroids[bvh_cells_[i]];
+    centroid_box = UnionBoxes(centroid_box, {c.x, c.x, c.y, c.y, c.z, c.z});
+  }
+  bvh_nodes_[node].box = box;
+
+  if (end - begin <= BVH_LEAF_SIZE) {
+    bvh_nodes_[node].first = static_cast<uint32_t>(begin);
+    bvh_nodes_[node].count = static_cast<uint32_t>(end - begin);
+    return node;
+  }
+
+  // median split along the widest spread of centroids
+  const double spread[3] = {centroid_box.x_max - centroid_box.x_min,
+                            centroid_box.y_max - centroid_box.y_min,
+                            centroid_box.z_max - centroid_box.z_min};
+  const int axis =
+      static_cast<int>(std::max_element(spread, spread + 3) - spread);
+  const size_t mid = begin + (end - begin) / 2;
+  std::nth_element(bvh_cells_.begin() + begin, bvh_cells_.begin() + mid,
+                   bvh_cells_.begin() + end, [&](uint32_t a, uint32_t b) {
+                     return Coordinate(centroids[a], axis) <
+                            Coordinate(centroids[b], axis);
+                   });
+
+  BuildBVH(begin, mid, boxes, centroids);
+  bvh_nodes_[node].first = BuildBVH(mid, end, boxes, centroids);
+  return node;
+}
+
+std::optional<uint32_t> Universe::FindCell(const std::vector<Cell>& cells,
+                                           const Point& p) const {
+  if (!bvh_nodes_.empty()) {
+    uint32_t stack[64];
+    size_t depth = 0;
+    stack[depth++] = 0;
+    while (depth > 0) {
+      const uint32_t index = stack[--depth];
+      const BVHNode& node = bvh_nodes_[index];
+      if (!node.box.Contains(p)) continue;
+      if (node.count > 0) {
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+          if (cells[bvh_cells_[i]].region.Contains(p)) return bvh_cells_[i];
+        }
+      } else {
+        stack[depth++] = node.first;
+        stack[depth++] = index + 1;
+      }
+    }
+  }
+
+  for (uint32_t cell : unbounded_cells_) {
+    if (cells[cell].region.Contains(p)) return cell;
+  }
+  return std::nullopt;
+}
+
+}  // namespace charmander
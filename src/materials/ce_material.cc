@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <vector>
 #include <stdexcept>
 #include <cmath>
@@ -5,10 +6,11 @@
 #include "constants.h"
 #include "materials/ce_material.h"
 #include "materials/nuclide.h"
+#include "materials/xs_kernels.h"
 
 namespace charmander
 {
-  CEMaterial::CEMaterial(const int id, const std::vector<NuclideData>& nuclide_data) : id_(id), nuclides_(nuclide_data) {
+  CEMaterial::CEMaterial(const int id, const std::vector<NuclideData>& nuclide_data, EnergySearch search) : id_(id), nuclides_(nuclide_data), search_(search) {
     // enforce not empty
     if (nuclides_.empty())
     {
@@ -38,27 +40,229 @@ namespace charmander
     {
       nucdatum.atom_percent /= total_at_percent;
     }
+
+    if (search_ == EnergySearch::UNION_GRID) BuildUnionGrid();
   }
 
-  double
-  CEMaterial::GetTotalXS(double energy) const {
-    float total_xs = 0.0f;
+  void
+  CEMaterial::BuildUnionEnergies() {
+    // merge every nuclide grid into one sorted, unique grid
+    union_energies_.clear();
+    for (const auto& nucdatum : nuclides_)
+    {
+      const auto& energies = nucdatum.nuc->GetEvaluationEnergies();
+      union_energies_.insert(union_energies_.end(), energies.begin(), energies.end());
+    }
+    std::sort(union_energies_.begin(), union_energies_.end());
+    union_energies_.erase(std::unique(union_energies_.begin(), union_energies_.end()), union_energies_.end());
+
+    if (union_energies_.size() < 2)
+    {
+      throw std::runtime_error("union energy grid for material " + std::to_string(id_) + " has fewer than 2 points");
+    }
+  }
+
+  void
+  CEMaterial::BuildUnionGrid() {
+    BuildUnionEnergies();
+
+    // for each union energy, the nuclide bin holding [E_u, E_u+1), clipped to
+    // the nuclide grid so the interpolation stays in bounds
+    const size_t n_nuclides = nuclides_.size();
+    union_index_map_.resize(union_energies_.size() * n_nuclides);
+    for (size_t j = 0; j < n_nuclides; ++j)
+    {
+      const auto& energies = nuclides_[j].nuc->GetEvaluationEnergies();
+      const size_t last_bin = energies.size() - 2;
+      size_t bin = 0;
+      for (size_t u = 0; u < union_energies_.size(); ++u)
+      {
+        // both grids are sorted, so walk forward instead of searching
+        while (bin < last_bin && energies[bin + 1] <= union_energies_[u]) ++bin;
+        union_index_map_[u * n_nuclides + j] = bin;
+      }
+    }
+  }
+
+  size_t
+  CEMaterial::GetUnionEnergyBin(double energy) const {
+    const size_t size_of_energies = union_energies_.size();
+    const double* energies = union_energies_.data();
+
+    if (energy <= energies[0]) return 0;
+    if (energy >= energies[size_of_energies - 1]) return size_of_energies - 2;
+
+    auto it = std::upper_bound(energies, energies + size_of_energies, energy);
+    return static_cast<size_t>(it - energies) - 1;
+  }
+
+  size_t
+  CEMaterial::GetSearchMemoryBytes() const {
+    switch (search_)
+    {
+      case EnergySearch::UNION_GRID:
+        return union_energies_.size() * sizeof(double) + union_index_map_.size() * sizeof(size_t);
+      case EnergySearch::HASH:
+      {
+        size_t bytes = 0;
+        for (const auto& nucdatum : nuclides_)
+        {
+          bytes += nucdatum.nuc->GetEnergyHashMemoryBytes();
+        }
+        return bytes;
+      }
+      case EnergySearch::BINARY:
+        break;
+    }
+    return 0;
+  }
+
+  void
+  CEMaterial::PrecomputeTotalXS() {
+    if (union_energies_.empty()) BuildUnionEnergies();
+
+    // every nuclide is linear between union points, so the summed table
+    // interpolates to the same value as summing the nuclides
+    total_xs_table_.assign(union_energies_.size(), 0.0);
     for (const auto& nucdata : nuclides_)
     {
-      size_t lower_energy = nuclides_.front().nuc->GetLowerEnergyBin(energy);
-      total_xs += nucdata.atom_percent * nucdata.nuc->GetTotalXS(lower_energy, energy);
+      for (size_t u = 0; u < union_energies_.size(); ++u)
+      {
+        const double energy = union_energies_[u];
+        const size_t bin = nucdata.nuc->GetLowerEnergyBin(energy);
+        total_xs_table_[u] += nucdata.atom_percent * nucdata.nuc->GetTotalXS(bin, energy);
+      }
     }
-    return static_cast<double>(total_xs);
+  }
+
+  size_t
+  CEMaterial::GetTotalXSTableMemoryBytes() const {
+    if (total_xs_table_.empty()) return 0;
+    size_t bytes = total_xs_table_.size() * sizeof(double);
+    // the union grid is only extra memory if the search did not already need it
+    if (search_ != EnergySearch::UNION_GRID) bytes += union_energies_.size() * sizeof(double);
+    return bytes;
   }
 
   double
-  CEMaterial::GetXSFromMT(MT mt, double energy) const {
-    float xs = 0.0f;
-    for (const auto& nucdata : nuclides_)
+  CEMaterial::GetTabulatedTotalXS(double energy) const {
+    if (energy <= union_energies_.front()) return total_xs_table_.front();
+    if (energy >= union_energies_.back()) return total_xs_table_.back();
+
+    const size_t bin = GetUnionEnergyBin(energy);
+    const double E_low = union_energies_[bin];
+    const double E_high = union_energies_[bin + 1];
+    const double XS_low = total_xs_table_[bin];
+    const double XS_high = total_xs_table_[bin + 1];
+
+    return XS_low + (XS_high - XS_low) * (energy - E_low) / (E_high - E_low);
+  }
+
+  template <typename Func>
+  void
+  CEMaterial::ForEachNuclideBin(double energy, Func&& func) const {
+    switch (search_)
     {
-      size_t lower_energy = nuclides_.front().nuc->GetLowerEnergyBin(energy);
-      xs += nucdata.atom_percent * nucdata.nuc->GetXSFromMT(mt, lower_energy, energy);
+      case EnergySearch::UNION_GRID:
+      {
+        const size_t n_nuclides = nuclides_.size();
+        const size_t* bins = union_index_map_.data() + GetUnionEnergyBin(energy) * n_nuclides;
+        for (size_t j = 0; j < n_nuclides; ++j)
+        {
+          func(nuclides_[j], bins[j]);
+        }
+        return;
+      }
+      case EnergySearch::HASH:
+        for (const auto& nucdata : nuclides_)
+        {
+          func(nucdata, nucdata.nuc->GetLowerEnergyBin(energy));
+        }
+        return;
+      case EnergySearch::BINARY:
+        for (const auto& nucdata : nuclides_)
+        {
+          func(nucdata, nucdata.nuc->BinarySearchEnergyBin(energy));
+        }
+        return;
     }
-    return static_cast<double>(xs);
+  }
+
+  double
+  CEMaterial::GetTotalXS(double energy) const {
+    if (!total_xs_table_.empty()) return GetTabulatedTotalXS(energy);
+
+    double total_xs = 0.0;
+    ForEachNuclideBin(energy, [&](const NuclideData& nucdata, size_t bin) {
+      total_xs += nucdata.atom_percent * nucdata.nuc->GetTotalXS(bin, energy);
+    });
+    return total_xs;
+  }
+
+  void
+  CEMaterial::GetTotalXS(std::span<const double> energies, std::span<double> xs) const {
+    if (energies.size() != xs.size())
+    {
+      throw std::runtime_error("batched xs lookup for material " + std::to_string(id_) + " got " + std::to_string(energies.size()) + " energies but " + std::to_string(xs.size()) + " outputs");
+    }
+
+    if (!total_xs_table_.empty())
+    {
+      const double E_min = union_energies_.front();
+      const double E_max = union_energies_.back();
+      size_t bins[XS_BATCH_SIZE];
+      double clipped[XS_BATCH_SIZE];
+      for (size_t start = 0; start < energies.size(); start += XS_BATCH_SIZE)
+      {
+        const size_t n = std::min(XS_BATCH_SIZE, energies.size() - start);
+        for (size_t i = 0; i < n; ++i)
+        {
+          clipped[i] = std::clamp(energies[start + i], E_min, E_max);
+          bins[i] = GetUnionEnergyBin(clipped[i]);
+          PrefetchRead(total_xs_table_.data() + bins[i]);
+        }
+        InterpolateTable(union_energies_.data(), total_xs_table_.data(), bins, clipped, xs.data() + start, n);
+      }
+      return;
+    }
+
+    double nuc_xs[XS_BATCH_SIZE];
+    for (size_t start = 0; start < energies.size(); start += XS_BATCH_SIZE)
+    {
+      const size_t n = std::min(XS_BATCH_SIZE, energies.size() - start);
+      auto pass_energies = energies.subspan(start, n);
+      auto pass_xs = xs.subspan(start, n);
+      std::fill(pass_xs.begin(), pass_xs.end(), 0.0);
+      for (const auto& nucdata : nuclides_)
+      {
+        nucdata.nuc->GetTotalXS(pass_energies, std::span<double>(nuc_xs, n));
+        for (size_t i = 0; i < n; ++i)
+        {
+          pass_xs[i] += nucdata.atom_percent * nuc_xs[i];
+        }
+      }
+    }
+  }
+
+  double
+  CEMaterial::GetXSFromMT(MT mt, double energy) const {
+    double xs = 0.0;
+    ForEachNuclideBin(energy, [&](const NuclideData& nucdata, size_t bin) {
+      xs += nucdata.atom_percent * nucdata.nuc->GetXSFromMT(mt, bin, energy);
+    });
+    return xs;
+  }
+
+  ReactionXS
+  CEMaterial::GetAllXS(double energy) const {
+    ReactionXS result;
+    ForEachNuclideBin(energy, [&](const NuclideData& nucdata, size_t bin) {
+      const ReactionXS nuc_xs = nucdata.nuc->GetAllXS(bin, energy);
+      for (size_t channel = 0; channel < NUM_XS_CHANNELS; ++channel)
+      {
+        result.xs[channel] += nucdata.atom_percent * nuc_xs.xs[channel];
+      }
+    });
+    return result;
   }
 } // namespace charmander
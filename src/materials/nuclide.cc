@@ -1,49 +1,205 @@
 #include "materials/nuclide.h"
 
 #include <algorithm>
+#include <cmath>
 #include <iterator>
+#include <stdexcept>
+#include <string>
 
+#include "constants.h"
+
+#include "materials/xs_cache.h"
 #include "materials/xs_file_interface.h"
+#include "materials/xs_kernels.h"
 
 namespace charmander {
 
-void Nuclide::LoadFromFile() {
-  
+namespace {
+// hdf5 reaction names of the partial channels, total is constructed
+constexpr const char* CHANNEL_MT_NAMES[NUM_XS_CHANNELS] = {nullptr, "002",
+                                                           "004", "018", "102"};
+constexpr ChannelMask PARTIAL_CHANNELS =
+    ALL_CHANNELS & ~(ChannelMask{1} << TOTAL_CHANNEL);
+}  // namespace
+
+void Nuclide::LoadFromFile(ChannelMask required) {
   if (AlreadyLoaded()) return;
-  
-  // open xs file
-  XSFileInterface xs_file(nuclide_name_);
-
-  // energies
-  xs_file.LoadEvaluationEnergies(temperature_, evaluation_energies_);
-
-  // fill the xs
-  xs_file.Load1DXSDataset("002", temperature_, xs_map_[MT::ELASTIC],
-                          evaluation_energies_.size());
-  xs_file.LeftPadLoad1DXSDataset("004", temperature_, xs_map_[MT::INELASTIC],
-                                 evaluation_energies_.size());
-  xs_file.Load1DXSDataset("018", temperature_, xs_map_[MT::FISSION],
-                          evaluation_energies_.size());
-  xs_file.Load1DXSDataset("102", temperature_, xs_map_[MT::CAPTURE],
-                          evaluation_energies_.size());
 
-  // calculate the total xs from the above
-  ConstructTotalXS();
+  if (auto cache_path = XSCache::ResolveCachePath(nuclide_name_, temperature_)) {
+    LoadFromXSCache(*cache_path);
+    return;
+  }
 
-  loaded_ = true;
+  LoadFromHDF5(required);
 };
 
-void Nuclide::ConstructTotalXS() {
-  total_xs_.clear();
+void Nuclide::LoadFromHDF5(ChannelMask required) {
+  if (AlreadyLoaded()) return;
+
+  // the total is built from every partial
+  if (required & (ChannelMask{1} << TOTAL_CHANNEL)) {
+    required |= PARTIAL_CHANNELS;
+  }
+
+  {
+    // only the reads are serialized, post processing below runs concurrently
+    auto hdf5_lock = XSFileInterface::LockHDF5();
+
+    // open xs file
+    XSFileInterface xs_file(nuclide_name_);
+
+    // energies
+    xs_file.LoadEvaluationEnergies(temperature_, energy_storage_);
+    evaluation_energies_ = energy_storage_;
+
+    // each required reaction is read straight into its column of the
+    // interleaved records
+    xs_storage_.assign(energy_storage_.size() * XS_RECORD_STRIDE, 0.0f);
+    xs_table_ = xs_storage_;
+    for (size_t channel = ELASTIC_CHANNEL; channel < NUM_XS_CHANNELS;
+         ++channel) {
+      if (required & (ChannelMask{1} << channel)) ReadChannel(xs_file, channel);
+    }
+  }
+
+  // calculate the total xs from the above
+  if (required & (ChannelMask{1} << TOTAL_CHANNEL)) ConstructTotalXS();
+
+  for (size_t channel = 0; channel < NUM_XS_CHANNELS; ++channel) {
+    if (required & (ChannelMask{1} << channel)) MarkChannelLoaded(channel);
+  }
+
+  // accelerate energy searches
+  BuildEnergyHash();
+
+  loaded_.store(true, std::memory_order_release);
+}
+
+void Nuclide::ReadChannel(const XSFileInterface& xs_file,
+                          size_t channel) const {
+  const size_t size_of_energies = evaluation_energies_.size();
+  float* column = xs_storage_.data() + channel;
+  if (channel == INELASTIC_CHANNEL) {
+    threshold_index_[channel] = xs_file.LoadThreshold1DXSDataset(
+        CHANNEL_MT_NAMES[channel], temperature_, column, XS_RECORD_STRIDE,
+        size_of_energies);
+  } else {
+    xs_file.Load1DXSDataset(CHANNEL_MT_NAMES[channel], temperature_, column,
+                            XS_RECORD_STRIDE, size_of_energies);
+  }
+}
+
+void Nuclide::LoadChannel(size_t channel) const {
+  if (!AlreadyLoaded()) {
+    throw std::runtime_error("cannot read xs of " + nuclide_name_ +
+                             " before it is loaded");
+  }
+  std::lock_guard<std::mutex> lock(channel_mutex_);
+  LoadChannelLocked(channel);
+}
+
+void Nuclide::LoadChannelLocked(size_t channel) const {
+  // another thread may have loaded it while we waited for the lock
+  if (channel_loaded_[channel].load(std::memory_order_acquire)) return;
+
+  if (channel == TOTAL_CHANNEL) {
+    for (size_t partial = ELASTIC_CHANNEL; partial < NUM_XS_CHANNELS;
+         ++partial) {
+      LoadChannelLocked(partial);
+    }
+    ConstructTotalXS();
+  } else {
+    auto hdf5_lock = XSFileInterface::LockHDF5();
+    XSFileInterface xs_file(nuclide_name_);
+    ReadChannel(xs_file, channel);
+  }
+  MarkChannelLoaded(channel);
+}
+
+void Nuclide::LoadFromXSCache(const std::string& path) {
+  if (AlreadyLoaded()) return;
+
+  XSCache cache(path);
+  const XSCacheHeader& header = cache.GetHeader();
+  if (nuclide_name_ != header.nuclide || temperature_ != header.temperature) {
+    throw std::runtime_error("XS cache " + path + " holds " +
+                             std::string(header.nuclide) + " at " +
+                             std::string(header.temperature) + ", expected " +
+                             nuclide_name_ + " at " + temperature_);
+  }
+
+  mapping_ = cache.GetMapping();
+  evaluation_energies_ = cache.GetEnergies();
+  xs_table_ = cache.GetTable();
+  for (size_t channel = 0; channel < NUM_XS_CHANNELS; ++channel) {
+    threshold_index_[channel] = header.threshold_index[channel];
+    MarkChannelLoaded(channel);
+  }
+
+  // the hash is cheap to rebuild and stays private to the process
+  BuildEnergyHash();
+
+  loaded_.store(true, std::memory_order_release);
+}
+
+void Nuclide::WriteXSCache(const std::string& path) const {
+  if (!AlreadyLoaded()) {
+    throw std::runtime_error("cannot cache " + nuclide_name_ +
+                             " before it is loaded");
+  }
+  EnsureAllChannels();
+  XSCache::Write(path, nuclide_name_, temperature_, evaluation_energies_,
+                 xs_table_, threshold_index_);
+}
+
+void Nuclide::ConstructTotalXS() const {
   size_t length = evaluation_energies_.size();
-  total_xs_.resize(length);
-  for (const auto& [mt, xs] : xs_map_) {
-    for (size_t i = 0; i < length; ++i) {
-      total_xs_[i] = xs[i];
+  for (size_t i = 0; i < length; ++i) {
+    float* record = xs_storage_.data() + i * XS_RECORD_STRIDE;
+    record[TOTAL_CHANNEL] = 0.0f;
+    for (size_t channel = ELASTIC_CHANNEL; channel < NUM_XS_CHANNELS;
+         ++channel) {
+      record[TOTAL_CHANNEL] += record[channel];
     }
   }
 };
 
+void Nuclide::BuildEnergyHash() {
+  const size_t size_of_energies = evaluation_energies_.size();
+
+  // log is undefined at zero, everything at or below the first positive
+  // energy falls into the first bucket
+  auto first_positive =
+      std::upper_bound(evaluation_energies_.begin(), evaluation_energies_.end(),
+                       0.0);
+  energy_hash_min_ = (first_positive != evaluation_energies_.end())
+                         ? *first_positive
+                         : evaluation_energies_.back();
+  energy_hash_log_min_ = std::log(energy_hash_min_);
+
+  const size_t n_buckets = std::min(MAX_ENERGY_HASH_BINS, size_of_energies);
+  const double log_width =
+      std::log(evaluation_energies_.back()) - energy_hash_log_min_;
+  energy_hash_inv_width_ =
+      (log_width > 0.0) ? static_cast<double>(n_buckets) / log_width : 0.0;
+
+  // bounds come from the same bucket function used at lookup, so rounding in
+  // the log can never put a point on the wrong side of a bound
+  energy_hash_bounds_.assign(n_buckets + 1, size_of_energies);
+  size_t next_bucket = 0;
+  for (size_t i = 0; i < size_of_energies; ++i) {
+    const size_t bucket = GetEnergyHashBucket(evaluation_energies_[i]);
+    while (next_bucket <= bucket) energy_hash_bounds_[next_bucket++] = i;
+  }
+}
+
+size_t Nuclide::GetEnergyHashBucket(double energy) const {
+  if (energy <= energy_hash_min_) return 0;
+  const size_t bucket = static_cast<size_t>(
+      (std::log(energy) - energy_hash_log_min_) * energy_hash_inv_width_);
+  return std::min(bucket, energy_hash_bounds_.size() - 2);
+}
+
 size_t Nuclide::GetLowerEnergyBin(double energy) const {
   const size_t size_of_energies = evaluation_energies_.size();
   const double* energies = evaluation_energies_.data();
@@ -51,41 +207,118 @@ size_t Nuclide::GetLowerEnergyBin(double energy) const {
   if (energy <= energies[0]) return 0;
   if (energy >= energies[size_of_energies - 1]) return size_of_energies - 2;
 
+  const size_t bucket = GetEnergyHashBucket(energy);
+  auto it = std::lower_bound(energies + energy_hash_bounds_[bucket],
+                             energies + energy_hash_bounds_[bucket + 1],
+                             energy);
+  return static_cast<size_t>(it - energies) - 1;
+}
+
+size_t Nuclide::BinarySearchEnergyBin(double energy) const {
+  const size_t size_of_energies = evaluation_energies_.size();
+  const double* energies = evaluation_energies_.data();
+
+  if (energy <= energies[0]) return 0;
+  if (energy >= energies[size_of_energies - 1]) return size_of_energies - 2;
+
   auto it = std::lower_bound(energies, energies + size_of_energies, energy);
   return static_cast<size_t>(it - energies) - 1;
 }
 
 double Nuclide::GetTotalXS(const size_t energy_index,
                            const double energy) const {
-  if (energy <= evaluation_energies_.front()) return total_xs_.front();
-  if (energy >= evaluation_energies_.back()) return total_xs_.back();
+  return GetXSFromChannel(TOTAL_CHANNEL, energy_index, energy);
+}
 
-  const double* energies = evaluation_energies_.data();
-  const float* xs = total_xs_.data();
+void Nuclide::GetTotalXS(std::span<const double> energies,
+                         std::span<double> xs) const {
+  if (energies.size() != xs.size()) {
+    throw std::runtime_error("batched xs lookup for " + nuclide_name_ +
+                             " got " + std::to_string(energies.size()) +
+                             " energies but " + std::to_string(xs.size()) +
+                             " outputs");
+  }
 
-  double E_low = energies[energy_index];
-  double E_high = energies[energy_index + 1];
+  EnsureChannel(TOTAL_CHANNEL);
 
-  double XS_low = xs[energy_index];
-  double XS_high = xs[energy_index + 1];
+  const double E_min = evaluation_energies_.front();
+  const double E_max = evaluation_energies_.back();
 
-  return XS_low + (XS_high - XS_low) * (energy - E_low) / (E_high - E_low);
+  size_t bins[XS_BATCH_SIZE];
+  double clipped[XS_BATCH_SIZE];
+  for (size_t start = 0; start < energies.size(); start += XS_BATCH_SIZE) {
+    const size_t n = std::min(XS_BATCH_SIZE, energies.size() - start);
+
+    // search pass, clipped energies interpolate onto the end points
+    for (size_t i = 0; i < n; ++i) {
+      const double energy = std::clamp(energies[start + i], E_min, E_max);
+      bins[i] = GetLowerEnergyBin(energy);
+      clipped[i] = energy;
+      PrefetchRead(evaluation_energies_.data() + bins[i]);
+      PrefetchRead(xs_table_.data() + bins[i] * XS_RECORD_STRIDE);
+    }
+
+    InterpolateRecordColumn(evaluation_energies_.data(),
+                            xs_table_.data() + TOTAL_CHANNEL, bins, clipped,
+                            xs.data() + start, n);
+  }
 }
 
 double Nuclide::GetXSFromMT(MT mt, const size_t energy_index,
                             const double energy) const {
-  const float* xs = xs_map_.at(mt).data();
+  return GetXSFromChannel(ChannelFromMT(mt), energy_index, energy);
+}
+
+ReactionXS Nuclide::GetAllXS(const size_t energy_index,
+                             const double energy) const {
+  ReactionXS result;
+  const size_t size_of_energies = evaluation_energies_.size();
+
+  // clip to the first or last record
+  if (energy <= evaluation_energies_.front() ||
+      energy >= evaluation_energies_.back()) {
+    const float* record = GetXSRecord(
+        energy <= evaluation_energies_.front() ? 0 : size_of_energies - 1);
+    for (size_t channel = 0; channel < NUM_XS_CHANNELS; ++channel) {
+      result.xs[channel] = record[channel];
+    }
+    return result;
+  }
+
+  const double* energies = evaluation_energies_.data();
+  const double E_low = energies[energy_index];
+  const double E_high = energies[energy_index + 1];
+  const double weight = (energy - E_low) / (E_high - E_low);
+
+  const float* low = GetXSRecord(energy_index);
+  const float* high = low + XS_RECORD_STRIDE;
+  for (size_t channel = 0; channel < NUM_XS_CHANNELS; ++channel) {
+    const double XS_low = low[channel];
+    result.xs[channel] = XS_low + (high[channel] - XS_low) * weight;
+  }
+  return result;
+}
+
+double Nuclide::GetXSFromChannel(const size_t channel,
+                                 const size_t energy_index,
+                                 const double energy) const {
+  EnsureChannel(channel);
+
+  // both bracketing points sit below the reaction threshold
+  if (energy_index + 1 < threshold_index_[channel]) return 0.0;
+
+  const float* xs = xs_table_.data() + channel;
   if (energy <= evaluation_energies_.front()) return xs[0];
   if (energy >= evaluation_energies_.back())
-    return xs[evaluation_energies_.size() - 1];
+    return xs[(evaluation_energies_.size() - 1) * XS_RECORD_STRIDE];
 
   const double* energies = evaluation_energies_.data();
 
   double E_low = energies[energy_index];
   double E_high = energies[energy_index + 1];
 
-  double XS_low = xs[energy_index];
-  double XS_high = xs[energy_index + 1];
+  double XS_low = xs[energy_index * XS_RECORD_STRIDE];
+  double XS_high = xs[(energy_index + 1) * XS_RECORD_STRIDE];
 
   return XS_low + (XS_high - XS_low) * (energy - E_low) / (E_high - E_low);
 }
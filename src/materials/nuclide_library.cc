@@ -0,0 +1,85 @@
+#include "materials/nuclide_library.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace charmander {
+
+std::shared_ptr<const Nuclide> NuclideLibrary::Get(
+    const std::string& nuclide, const std::string& temperature,
+    ChannelMask required) {
+  std::shared_ptr<Entry> entry;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& slot = entries_[Key(nuclide, temperature)];
+    if (!slot) {
+      slot = std::make_shared<Entry>();
+      slot->nuclide = std::make_shared<Nuclide>(nuclide, temperature);
+    }
+    entry = slot;
+  }
+
+  // a failed load leaves the flag unset, so the next request retries
+  std::call_once(entry->loaded, [&] {
+    entry->nuclide->LoadFromFile(required);
+  });
+  return entry->nuclide;
+}
+
+void NuclideLibrary::LoadAll(const std::vector<std::string>& nuclides,
+                             const std::string& temperature,
+                             size_t n_threads, ChannelMask required) {
+  std::vector<std::string> unique_nuclides = nuclides;
+  std::sort(unique_nuclides.begin(), unique_nuclides.end());
+  unique_nuclides.erase(
+      std::unique(unique_nuclides.begin(), unique_nuclides.end()),
+      unique_nuclides.end());
+
+  if (n_threads == 0) n_threads = std::max(1u, std::thread::hardware_concurrency());
+  n_threads = std::min(n_threads, unique_nuclides.size());
+
+  std::atomic<size_t> next{0};
+  std::mutex error_mutex;
+  std::exception_ptr first_error;
+
+  auto worker = [&] {
+    for (size_t i = next++; i < unique_nuclides.size(); i = next++) {
+      try {
+        Get(unique_nuclides[i], temperature, required);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!first_error) first_error = std::current_exception();
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t t = 1; t < n_threads; ++t) workers.emplace_back(worker);
+  worker();
+  for (auto& thread : workers) thread.join();
+
+  if (first_error) std::rethrow_exception(first_error);
+}
+
+bool NuclideLibrary::Contains(const std::string& nuclide,
+                              const std::string& temperature) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(Key(nuclide, temperature));
+  return it != entries_.end() && it->second->nuclide->AlreadyLoaded();
+}
+
+size_t NuclideLibrary::Size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t loaded = 0;
+  for (const auto& [key, entry] : entries_) {
+    if (entry->nuclide->AlreadyLoaded()) ++loaded;
+  }
+  return loaded;
+}
+
+}  // namespace charmander
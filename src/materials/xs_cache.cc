@@ -0,0 +1,203 @@
+#include "materials/xs_cache.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "constants.h"
+
+namespace charmander {
+
+namespace {
+uint64_t AlignUp(uint64_t offset) {
+  return (offset + CACHE_LINE_BYTES - 1) / CACHE_LINE_BYTES * CACHE_LINE_BYTES;
+}
+
+void CopyName(char* dest, size_t dest_size, const std::string& name,
+              const std::string& what) {
+  if (name.size() >= dest_size) {
+    throw std::runtime_error("XS cache " + what + " '" + name +
+                             "' is longer than " +
+                             std::to_string(dest_size - 1) + " characters");
+  }
+  std::memset(dest, 0, dest_size);
+  std::memcpy(dest, name.data(), name.size());
+}
+}  // namespace
+
+// ----------------------------------------------------------------------------
+// MappedFile
+// ----------------------------------------------------------------------------
+
+MappedFile::MappedFile(const std::string& path) {
+#ifdef _WIN32
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) throw std::runtime_error("Failed to open XS cache: " + path);
+  size_ = static_cast<size_t>(file.tellg());
+  buffer_.resize(size_);
+  file.seekg(0);
+  if (!file.read(reinterpret_cast<char*>(buffer_.data()), size_)) {
+    throw std::runtime_error("Failed to read XS cache: " + path);
+  }
+  data_ = buffer_.data();
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw std::runtime_error("Failed to open XS cache: " + path);
+
+  struct stat info;
+  if (fstat(fd, &info) < 0) {
+    close(fd);
+    throw std::runtime_error("Failed to stat XS cache: " + path);
+  }
+  size_ = static_cast<size_t>(info.st_size);
+  if (size_ == 0) {
+    close(fd);
+    throw std::runtime_error("XS cache is empty: " + path);
+  }
+
+  void* address = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  // the mapping keeps its own reference to the file
+  close(fd);
+  if (address == MAP_FAILED) {
+    throw std::runtime_error("Failed to map XS cache: " + path);
+  }
+  data_ = static_cast<const std::byte*>(address);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+  if (data_) munmap(const_cast<std::byte*>(data_), size_);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// XSCache
+// ----------------------------------------------------------------------------
+
+std::string XSCache::CacheFileName(const std::string& nuclide,
+                                   const std::string& temperature) {
+  return nuclide + "_" + temperature + ".cxs";
+}
+
+std::optional<std::string> XSCache::ResolveCachePath(
+    const std::string& nuclide, const std::string& temperature) {
+  const char* var = std::getenv("CHARMANDER_XS_CACHE");
+  if (!var) return std::nullopt;
+
+  std::filesystem::path cache_file =
+      std::filesystem::path(var) / CacheFileName(nuclide, temperature);
+  if (!std::filesystem::exists(cache_file)) return std::nullopt;
+  return cache_file.string();
+}
+
+void XSCache::Write(const std::string& path, const std::string& nuclide,
+                    const std::string& temperature,
+                    std::span<const double> energies,
+                    std::span<const float> table,
+                    std::span<const size_t, NUM_XS_CHANNELS> threshold_index) {
+  if (table.size() != energies.size() * XS_RECORD_STRIDE) {
+    throw std::runtime_error("XS cache for " + nuclide +
+                             " has a table that does not match its energies");
+  }
+
+  XSCacheHeader header{};
+  std::memcpy(header.magic, XS_CACHE_MAGIC, sizeof(header.magic));
+  header.version = XS_CACHE_VERSION;
+  header.endian_check = XS_CACHE_ENDIAN_CHECK;
+  CopyName(header.nuclide, sizeof(header.nuclide), nuclide, "nuclide");
+  CopyName(header.temperature, sizeof(header.temperature), temperature,
+           "temperature");
+  header.record_stride = XS_RECORD_STRIDE;
+  header.num_channels = NUM_XS_CHANNELS;
+  header.n_energies = energies.size();
+  header.energies_offset = AlignUp(sizeof(XSCacheHeader));
+  header.table_offset =
+      AlignUp(header.energies_offset + energies.size_bytes());
+  for (size_t channel = 0; channel < NUM_XS_CHANNELS; ++channel) {
+    header.threshold_index[channel] = threshold_index[channel];
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) throw std::runtime_error("Failed to create XS cache: " + path);
+
+  const std::vector<char> padding(CACHE_LINE_BYTES, 0);
+  auto pad_to = [&](uint64_t offset) {
+    file.write(padding.data(), offset - static_cast<uint64_t>(file.tellp()));
+  };
+
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  pad_to(header.energies_offset);
+  file.write(reinterpret_cast<const char*>(energies.data()),
+             energies.size_bytes());
+  pad_to(header.table_offset);
+  file.write(reinterpret_cast<const char*>(table.data()), table.size_bytes());
+
+  if (!file) throw std::runtime_error("Failed to write XS cache: " + path);
+}
+
+XSCache::XSCache(const std::string& path)
+    : mapping_(std::make_shared<const MappedFile>(path)) {
+  if (mapping_->Size() < sizeof(XSCacheHeader)) {
+    throw std::runtime_error("XS cache is too small for its header: " + path);
+  }
+  std::memcpy(&header_, mapping_->Data(), sizeof(XSCacheHeader));
+
+  if (std::memcmp(header_.magic, XS_CACHE_MAGIC, sizeof(header_.magic)) != 0) {
+    throw std::runtime_error("Not an XS cache file: " + path);
+  }
+  if (header_.version != XS_CACHE_VERSION) {
+    throw std::runtime_error(
+        "XS cache " + path + " has version " + std::to_string(header_.version) +
+        ", expected " + std::to_string(XS_CACHE_VERSION) + ". Rebuild it.");
+  }
+  if (!std::memchr(header_.nuclide, '\0', sizeof(header_.nuclide)) ||
+      !std::memchr(header_.temperature, '\0', sizeof(header_.temperature))) {
+    throw std::runtime_error("XS cache " + path + " has a corrupt header");
+  }
+  if (header_.endian_check != XS_CACHE_ENDIAN_CHECK) {
+    throw std::runtime_error("XS cache " + path +
+                             " was written with a different byte order");
+  }
+  if (header_.record_stride != XS_RECORD_STRIDE ||
+      header_.num_channels != NUM_XS_CHANNELS) {
+    throw std::runtime_error("XS cache " + path +
+                             " has a different record layout. Rebuild it.");
+  }
+  if (header_.n_energies < 2) {
+    throw std::runtime_error("XS cache " + path +
+                             " has fewer than 2 energies");
+  }
+
+  const uint64_t table_bytes =
+      header_.n_energies * XS_RECORD_STRIDE * sizeof(float);
+  if (header_.energies_offset % CACHE_LINE_BYTES != 0 ||
+      header_.table_offset % CACHE_LINE_BYTES != 0 ||
+      header_.energies_offset + header_.n_energies * sizeof(double) >
+          header_.table_offset ||
+      header_.table_offset + table_bytes > mapping_->Size()) {
+    throw std::runtime_error("XS cache " + path + " is truncated or corrupt");
+  }
+
+  const std::byte* data = mapping_->Data();
+  energies_ = std::span<const double>(
+      reinterpret_cast<const double*>(data + header_.energies_offset),
+      header_.n_energies);
+  table_ = std::span<const float>(
+      reinterpret_cast<const float*>(data + header_.table_offset),
+      header_.n_energies * XS_RECORD_STRIDE);
+}
+
+}  // namespace charmander
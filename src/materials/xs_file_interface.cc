@@ -7,6 +7,7 @@
 #include <exception>
 #include <filesystem>
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -37,6 +38,16 @@ std::string XSFileInterface::ResolveFilePath(const std::string& nuclide) {
   return xs_file.string();
 }
 
+std::unique_lock<std::mutex> XSFileInterface::LockHDF5() {
+  static std::mutex hdf5_mutex;
+  static const bool thread_safe = [] {
+    hbool_t is_thread_safe = 0;
+    return H5is_library_threadsafe(&is_thread_safe) >= 0 && is_thread_safe;
+  }();
+  if (thread_safe) return std::unique_lock<std::mutex>(hdf5_mutex, std::defer_lock);
+  return std::unique_lock<std::mutex>(hdf5_mutex);
+}
+
 hid_t XSFileInterface::OpenXSFile(const std::string& filename) const {
   hid_t file_id = H5Fopen(filename.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
   if (file_id < 0)
@@ -106,14 +117,69 @@ void XSFileInterface::LeftPadLoad1DXSDataset(const std::string& mt_rxn,
                              " is larger than the corresponding energy grid.");
   }
   size_t left_pad_size = target_size - size;
-  std::vector<float> temporary_holder(size);
-  if (H5LTread_dataset_float(file_id_, path.c_str(), temporary_holder.data()) <
-      0) {
+  xs.assign(target_size, 0.0f);
+  ReadStrided1DXSDataset(mt_rxn, path, xs.data() + left_pad_size, 1, size);
+}
+
+void XSFileInterface::Load1DXSDataset(const std::string& mt_rxn,
+                                      const std::string& temperature,
+                                      float* xs, const size_t& stride,
+                                      const size_t& target_size) const {
+  std::string path = Get1DXSDataPath(mt_rxn, temperature);
+  size_t size = Get1DDatasetSize(path);
+  if (size != target_size) {
+    throw std::runtime_error("XS data for MT " + mt_rxn + " has size " +
+                             std::to_string(size) + ", but energy size is " +
+                             std::to_string(target_size));
+  }
+  ReadStrided1DXSDataset(mt_rxn, path, xs, stride, size);
+}
+
+size_t XSFileInterface::LoadThreshold1DXSDataset(
+    const std::string& mt_rxn, const std::string& temperature, float* xs,
+    const size_t& stride, const size_t& target_size) const {
+  std::string path = Get1DXSDataPath(mt_rxn, temperature);
+  size_t size = Get1DDatasetSize(path);
+  if (size > target_size) {
+    throw std::runtime_error("Threshold reaction MT " + mt_rxn +
+                             " is larger than the corresponding energy grid.");
+  }
+  size_t threshold_index = target_size - size;
+  ReadStrided1DXSDataset(mt_rxn, path, xs + threshold_index * stride, stride,
+                         size);
+  return threshold_index;
+}
+
+void XSFileInterface::ReadStrided1DXSDataset(const std::string& mt_rxn,
+                                             const std::string& path,
+                                             float* xs, const size_t& stride,
+                                             const size_t& size) const {
+  if (size == 0) return;
+
+  hid_t dataset_id = H5Dopen2(file_id_, path.c_str(), H5P_DEFAULT);
+  if (dataset_id < 0) {
+    throw std::runtime_error("Failed to open MT " + mt_rxn + " xs: " + path);
+  }
+
+  // every stride-th float of the destination, so hdf5 scatters the dataset
+  // in place instead of going through a contiguous buffer
+  hsize_t memory_size = (size - 1) * stride + 1;
+  hsize_t start = 0;
+  hsize_t memory_stride = stride;
+  hsize_t count = size;
+  hid_t memory_space = H5Screate_simple(1, &memory_size, nullptr);
+  herr_t status = H5Sselect_hyperslab(memory_space, H5S_SELECT_SET, &start,
+                                      &memory_stride, &count, nullptr);
+  if (status >= 0) {
+    status = H5Dread(dataset_id, H5T_NATIVE_FLOAT, memory_space, H5S_ALL,
+                     H5P_DEFAULT, xs);
+  }
+  H5Sclose(memory_space);
+  H5Dclose(dataset_id);
+
+  if (status < 0) {
     throw std::runtime_error("Failed to read MT " + mt_rxn + " xs: " + path);
   }
-  xs.assign(target_size, 0.0f);
-  std::copy(temporary_holder.begin(), temporary_holder.end(),
-            xs.begin() + left_pad_size);
 }
 
 std::string XSFileInterface::Get1DXSDataPath(
@@ -0,0 +1,125 @@
+#include "materials/xs_kernels.h"
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include <cstddef>
+
+#include "materials/nuclide.h"
+
+namespace charmander {
+
+namespace {
+// records are power of two strides, so record offsets are a shift of the bin
+constexpr int RecordShift() {
+  int shift = 0;
+  while ((size_t{1} << shift) < XS_RECORD_STRIDE) ++shift;
+  return shift;
+}
+constexpr int RECORD_SHIFT = RecordShift();
+static_assert((size_t{1} << RECORD_SHIFT) == XS_RECORD_STRIDE);
+// gathers use the bins directly as 64 bit lane indices
+static_assert(sizeof(size_t) == 8);
+
+inline double Interpolate(double E_low, double E_high, double XS_low,
+                          double XS_high, double energy) {
+  const double weight = (energy - E_low) / (E_high - E_low);
+  return XS_low + (XS_high - XS_low) * weight;
+}
+}  // namespace
+
+void InterpolateRecordColumn(const double* grid, const float* column,
+                             const size_t* bins, const double* energies,
+                             double* xs, size_t n) {
+  size_t i = 0;
+#if defined(__AVX512F__)
+  for (; i + 8 <= n; i += 8) {
+    const __m512i bin = _mm512_loadu_si512(bins + i);
+    const __m512i record = _mm512_slli_epi64(bin, RECORD_SHIFT);
+    const __m512d E_low = _mm512_i64gather_pd(bin, grid, 8);
+    const __m512d E_high = _mm512_i64gather_pd(bin, grid + 1, 8);
+    const __m512d XS_low =
+        _mm512_cvtps_pd(_mm512_i64gather_ps(record, column, 4));
+    const __m512d XS_high = _mm512_cvtps_pd(
+        _mm512_i64gather_ps(record, column + XS_RECORD_STRIDE, 4));
+    const __m512d weight =
+        _mm512_div_pd(_mm512_sub_pd(_mm512_loadu_pd(energies + i), E_low),
+                      _mm512_sub_pd(E_high, E_low));
+    _mm512_storeu_pd(
+        xs + i,
+        _mm512_add_pd(XS_low,
+                      _mm512_mul_pd(_mm512_sub_pd(XS_high, XS_low), weight)));
+  }
+#elif defined(__AVX2__)
+  for (; i + 4 <= n; i += 4) {
+    const __m256i bin =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bins + i));
+    const __m256i record = _mm256_slli_epi64(bin, RECORD_SHIFT);
+    const __m256d E_low = _mm256_i64gather_pd(grid, bin, 8);
+    const __m256d E_high = _mm256_i64gather_pd(grid + 1, bin, 8);
+    const __m256d XS_low =
+        _mm256_cvtps_pd(_mm256_i64gather_ps(column, record, 4));
+    const __m256d XS_high = _mm256_cvtps_pd(
+        _mm256_i64gather_ps(column + XS_RECORD_STRIDE, record, 4));
+    const __m256d weight =
+        _mm256_div_pd(_mm256_sub_pd(_mm256_loadu_pd(energies + i), E_low),
+                      _mm256_sub_pd(E_high, E_low));
+    _mm256_storeu_pd(
+        xs + i,
+        _mm256_add_pd(XS_low,
+                      _mm256_mul_pd(_mm256_sub_pd(XS_high, XS_low), weight)));
+  }
+#endif
+  for (; i < n; ++i) {
+    const size_t bin = bins[i];
+    const float* record = column + (bin << RECORD_SHIFT);
+    xs[i] = Interpolate(grid[bin], grid[bin + 1], record[0],
+                        record[XS_RECORD_STRIDE], energies[i]);
+  }
+}
+
+void InterpolateTable(const double* grid, const double* table,
+                      const size_t* bins, const double* energies, double* xs,
+                      size_t n) {
+  size_t i = 0;
+#if defined(__AVX512F__)
+  for (; i + 8 <= n; i += 8) {
+    const __m512i bin = _mm512_loadu_si512(bins + i);
+    const __m512d E_low = _mm512_i64gather_pd(bin, grid, 8);
+    const __m512d E_high = _mm512_i64gather_pd(bin, grid + 1, 8);
+    const __m512d XS_low = _mm512_i64gather_pd(bin, table, 8);
+    const __m512d XS_high = _mm512_i64gather_pd(bin, table + 1, 8);
+    const __m512d weight =
+        _mm512_div_pd(_mm512_sub_pd(_mm512_loadu_pd(energies + i), E_low),
+                      _mm512_sub_pd(E_high, E_low));
+    _mm512_storeu_pd(
+        xs + i,
+        _mm512_add_pd(XS_low,
+                      _mm512_mul_pd(_mm512_sub_pd(XS_high, XS_low), weight)));
+  }
+#elif defined(__AVX2__)
+  for (; i + 4 <= n; i += 4) {
+    const __m256i bin =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bins + i));
+    const __m256d E_low = _mm256_i64gather_pd(grid, bin, 8);
+    const __m256d E_high = _mm256_i64gather_pd(grid + 1, bin, 8);
+    const __m256d XS_low = _mm256_i64gather_pd(table, bin, 8);
+    const __m256d XS_high = _mm256_i64gather_pd(table + 1, bin, 8);
+    const __m256d weight =
+        _mm256_div_pd(_mm256_sub_pd(_mm256_loadu_pd(energies + i), E_low),
+                      _mm256_sub_pd(E_high, E_low));
+    _mm256_storeu_pd(
+        xs + i,
+        _mm256_add_pd(XS_low,
+                      _mm256_mul_pd(_mm256_sub_pd(XS_high, XS_low), weight)));
+  }
+#endif
+  for (; i < n; ++i) {
+    const size_t bin = bins[i];
+    xs[i] = Interpolate(grid[bin], grid[bin + 1], table[bin], table[bin + 1],
+                        energies[i]);
+  }
+}
+
+}  // namespace charmander
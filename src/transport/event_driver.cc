@@ -0,0 +1,345 @@
+#include "transport/event_driver.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "aligned_allocator.h"
+#include "constants.h"
+#include "transport/particle_bank.h"
+#include "transport/philox.h"
+
+namespace charmander {
+
+// per particle state of a batch. positions, directions and energies live in
+// the bank, the rest is what the kernels hand each other
+struct EventDriver::Batch {
+  ParticleBank bank;
+  std::vector<GeometryLocation> locations;
+  std::vector<TransportRNG> rngs;
+  std::vector<uint64_t> events;
+  AlignedVector<double> total_xs;
+  std::vector<GeometryCrossing> crossings;
+  // majorant of each particle's energy, zero without one
+  AlignedVector<double> majorant_xs;
+  // delta tracked flights ending at a collision point that is accepted or
+  // rejected once the xs there is looked up
+  std::vector<uint8_t> tentative;
+
+  // indices into the bank waiting on each event
+  std::vector<uint32_t> lookup_queue;
+  std::vector<uint32_t> advance_queue;
+  std::vector<uint32_t> cross_queue;
+  std::vector<uint32_t> collide_queue;
+  // the tentative collisions of the advance queue
+  std::vector<uint32_t> tentative_queue;
+
+  // gathered energies and xs of one material's lookups
+  AlignedVector<double> lookup_energies;
+  AlignedVector<double> lookup_xs;
+  // one draw per particle of a queue
+  AlignedVector<double> uniforms;
+};
+
+EventDriver::EventDriver(const TransportProblem& problem, size_t batch_size)
+    : problem_(problem), batch_size_(batch_size) {
+  if (batch_size_ == 0) {
+    throw std::runtime_error("event batches need at least one particle");
+  }
+}
+
+TransportTally EventDriver::Run(uint64_t n_particles, uint64_t seed,
+                                size_t n_threads) const {
+  problem_.Validate();
+
+  if (n_threads == 0) {
+    n_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  const uint64_t n_batches = (n_particles + batch_size_ - 1) / batch_size_;
+  n_threads = static_cast<size_t>(std::max<uint64_t>(
+      1, std::min<uint64_t>(n_threads, n_batches)));
+
+  const size_t n_cells = problem_.GetGeometry().GetNumCells();
+  // batches are summed in batch order so the flux is the same whichever
+  // thread ran each batch
+  OrderedTallyReduction reduction(
+      n_batches, n_cells,
+      OrderedTallyReduction::WINDOW_PER_THREAD * n_threads);
+  std::mutex error_mutex;
+  std::exception_ptr first_error;
+
+  auto worker = [&] {
+    try {
+      uint64_t batch;
+      TransportTally* tally;
+      while (reduction.Next(batch, tally)) {
+        const uint64_t first = batch * batch_size_;
+        const size_t n = static_cast<size_t>(
+            std::min<uint64_t>(batch_size_, n_particles - first));
+        TransportBatch(first, n, seed, *tally);
+        reduction.Finish(batch);
+      }
+    } catch (...) {
+      {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!first_error) first_error = std::current_exception();
+      }
+      reduction.Abort();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t t = 1; t < n_threads; ++t) workers.emplace_back(worker);
+  worker();
+  for (auto& thread : workers) thread.join();
+
+  if (first_error) std::rethrow_exception(first_error);
+  return reduction.TakeResult();
+}
+
+void EventDriver::TransportBatch(uint64_t first, size_t n, uint64_t seed,
+                                 TransportTally& tally) const {
+  const Geometry& geometry = problem_.GetGeometry();
+
+  Batch batch;
+  batch.bank.Reserve(n);
+  batch.locations.reserve(n);
+  batch.rngs.reserve(n);
+  batch.events.assign(n, 0);
+  batch.total_xs.assign(n, 0.0);
+  batch.crossings.resize(n);
+  batch.majorant_xs.assign(n, 0.0);
+  batch.tentative.assign(n, 0);
+  const MajorantXS& majorant = problem_.GetMajorant();
+
+  // source, the born particles queue for their first lookup
+  for (size_t i = 0; i < n; ++i) {
+    TransportRNG& rng = batch.rngs.emplace_back(ParticleRNG(seed, first + i));
+    const SourceSite site = problem_.SampleSource(rng);
+    batch.bank.Add(site.position, site.direction, site.energy);
+    if (!majorant.Empty()) batch.majorant_xs[i] = majorant.GetXS(site.energy);
+    ++tally.histories;
+
+    auto location = geometry.Locate(site.position.ToPoint());
+    if (location) {
+      batch.bank.cell[i] = static_cast<int32_t>(location->GetCell());
+      batch.lookup_queue.push_back(static_cast<uint32_t>(i));
+      batch.locations.push_back(std::move(*location));
+    } else {
+      ++tally.lost;
+      batch.locations.emplace_back();
+    }
+  }
+
+  while (!batch.lookup_queue.empty()) {
+    LookupXS(batch);
+    SampleTentative(batch, tally);
+    Advance(batch, tally);
+    CrossSurfaces(batch, tally);
+    Collide(batch, tally);
+  }
+}
+
+void EventDriver::LookupXS(Batch& batch) const {
+  const Geometry& geometry = problem_.GetGeometry();
+  ParticleBank& bank = batch.bank;
+  auto& queue = batch.lookup_queue;
+
+  auto material_id = [&](uint32_t i) {
+    return geometry.GetCell(bank.cell[i]).material_id;
+  };
+  std::sort(queue.begin(), queue.end(), [&](uint32_t a, uint32_t b) {
+    const int material_a = material_id(a);
+    const int material_b = material_id(b);
+    if (material_a != material_b) return material_a < material_b;
+    return bank.E[a] < bank.E[b];
+  });
+
+  // one batched lookup per run of particles in the same material
+  for (size_t start = 0; start < queue.size();) {
+    const int id = material_id(queue[start]);
+    size_t end = start + 1;
+    while (end < queue.size() && material_id(queue[end]) == id) ++end;
+
+    const TransportMaterial* material = problem_.GetMaterial(id);
+    if (!material) {
+      for (size_t q = start; q < end; ++q) batch.total_xs[queue[q]] = 0.0;
+    } else {
+      const size_t count = end - start;
+      batch.lookup_energies.resize(count);
+      batch.lookup_xs.resize(count);
+      for (size_t q = 0; q < count; ++q) {
+        batch.lookup_energies[q] = bank.E[queue[start + q]];
+      }
+      material->material->GetTotalXS(
+          std::span<const double>(batch.lookup_energies),
+          std::span<double>(batch.lookup_xs));
+      for (size_t q = 0; q < count; ++q) {
+        batch.total_xs[queue[start + q]] =
+            material->atom_density * batch.lookup_xs[q];
+      }
+    }
+    start = end;
+  }
+
+  // the advance queue keeps the sorted order, and hands it on to collisions
+  batch.advance_queue.swap(queue);
+  queue.clear();
+}
+
+void EventDriver::SampleTentative(Batch& batch, TransportTally& tally) const {
+  auto& queue = batch.advance_queue;
+  batch.tentative_queue.clear();
+  for (uint32_t i : queue) {
+    if (batch.tentative[i]) batch.tentative_queue.push_back(i);
+  }
+  if (batch.tentative_queue.empty()) return;
+
+  batch.uniforms.resize(batch.tentative_queue.size());
+  NextUniforms(batch.rngs, batch.tentative_queue, batch.uniforms);
+  for (size_t q = 0; q < batch.tentative_queue.size(); ++q) {
+    const uint32_t i = batch.tentative_queue[q];
+    if (AcceptDeltaCollision(batch.total_xs[i], batch.majorant_xs[i],
+                             batch.uniforms[q])) {
+      batch.collide_queue.push_back(i);
+    } else {
+      // rejected, flies on from the collision point
+      ++tally.virtual_collisions;
+      batch.tentative[i] = 0;
+    }
+  }
+
+  // real collisions skip the advance
+  std::erase_if(queue, [&](uint32_t i) {
+    if (!batch.tentative[i]) return false;
+    batch.tentative[i] = 0;
+    return true;
+  });
+}
+
+void EventDriver::Advance(Batch& batch, TransportTally& tally) const {
+  const Geometry& geometry = problem_.GetGeometry();
+  ParticleBank& bank = batch.bank;
+
+  // every flight is an event, the one after a virtual collision included
+  auto& queue = batch.advance_queue;
+  std::erase_if(queue, [&](uint32_t i) {
+    if (problem_.CountEvent(batch.events[i])) return false;
+    ++tally.lost;
+    return true;
+  });
+
+  // flight distances of the whole queue from one batched draw
+  batch.uniforms.resize(queue.size());
+  NextUniforms(batch.rngs, queue, batch.uniforms);
+
+  for (size_t q = 0; q < queue.size(); ++q) {
+    const uint32_t i = queue[q];
+    if (problem_.GetTracking(bank.cell[i]) == TrackingMode::DELTA) {
+      AdvanceDelta(batch, i, batch.uniforms[q], tally);
+      continue;
+    }
+
+    const double collision =
+        CollisionDistance(batch.total_xs[i], batch.uniforms[q]);
+    const GeometryCrossing crossing = geometry.NextCrossing(
+        batch.locations[i], bank.GetDirection(i).ToDirection());
+
+    if (collision < crossing.boundary.distance) {
+      tally.flux[bank.cell[i]] += collision;
+      batch.locations[i].Move(bank.GetDirection(i), collision);
+      bank.SetPosition(i, batch.locations[i].GetPosition());
+      batch.collide_queue.push_back(i);
+    } else if (crossing.boundary.distance == INF) {
+      // an unbounded void never ends
+      ++tally.lost;
+    } else {
+      tally.flux[bank.cell[i]] += crossing.boundary.distance;
+      batch.crossings[i] = crossing;
+      batch.cross_queue.push_back(i);
+    }
+  }
+  queue.clear();
+}
+
+void EventDriver::AdvanceDelta(Batch& batch, uint32_t i, double xi,
+                               TransportTally& tally) const {
+  ParticleBank& bank = batch.bank;
+
+  // with nothing to collide with anywhere the flight ends outside
+  const double flight = CollisionDistance(batch.majorant_xs[i], xi);
+  if (flight == INF) {
+    ++tally.leaks;
+    return;
+  }
+  const Vec3 p = bank.GetPosition(i) + flight * bank.GetDirection(i);
+  if (!problem_.GetGeometry().Locate(p.ToPoint(), batch.locations[i])) {
+    ++tally.leaks;
+    return;
+  }
+
+  bank.SetPosition(i, p);
+  bank.cell[i] = static_cast<int32_t>(batch.locations[i].GetCell());
+  tally.flux[bank.cell[i]] += 1.0 / batch.majorant_xs[i];
+  batch.tentative[i] = 1;
+  batch.lookup_queue.push_back(i);
+}
+
+void EventDriver::CrossSurfaces(Batch& batch, TransportTally& tally) const {
+  const Geometry& geometry = problem_.GetGeometry();
+  ParticleBank& bank = batch.bank;
+
+  for (uint32_t i : batch.cross_queue) {
+    const GeometryCrossing& crossing = batch.crossings[i];
+    const Vec3 p = bank.GetPosition(i) +
+                   (crossing.boundary.distance + BOUNDARY_NUDGE) *
+                       bank.GetDirection(i);
+    ++tally.crossings;
+    if (!geometry.Cross(batch.locations[i], crossing, p.ToPoint())) {
+      ++tally.leaks;
+      continue;
+    }
+    bank.SetPosition(i, p);
+    bank.cell[i] = static_cast<int32_t>(batch.locations[i].GetCell());
+    batch.lookup_queue.push_back(i);
+  }
+  batch.cross_queue.clear();
+}
+
+void EventDriver::Collide(Batch& batch, TransportTally& tally) const {
+  const Geometry& geometry = problem_.GetGeometry();
+  ParticleBank& bank = batch.bank;
+
+  const auto& queue = batch.collide_queue;
+  batch.uniforms.resize(queue.size());
+  NextUniforms(batch.rngs, queue, batch.uniforms);
+
+  for (size_t q = 0; q < queue.size(); ++q) {
+    const uint32_t i = queue[q];
+    const TransportMaterial* material =
+        problem_.GetMaterial(geometry.GetCell(bank.cell[i]).material_id);
+    ++tally.collisions;
+    const ReactionXS xs = material->material->GetAllXS(bank.E[i]);
+    switch (SampleCollision(xs, batch.uniforms[q])) {
+      case CollisionType::SCATTER:
+        bank.SetDirection(i, SampleIsotropicDirection(batch.rngs[i]));
+        batch.lookup_queue.push_back(i);
+        break;
+      case CollisionType::CAPTURE:
+        ++tally.captures;
+        break;
+      case CollisionType::FISSION:
+        ++tally.fissions;
+        break;
+    }
+  }
+  batch.collide_queue.clear();
+}
+
+}  // namespace charmander
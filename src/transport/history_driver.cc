@@ -0,0 +1,158 @@
+#include "transport/history_driver.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "constants.h"
+
+namespace charmander {
+
+HistoryDriver::HistoryDriver(const TransportProblem& problem)
+    : problem_(problem) {}
+
+TransportTally HistoryDriver::Run(uint64_t n_particles, uint64_t seed,
+                                  size_t n_threads) const {
+  problem_.Validate();
+
+  if (n_threads == 0) {
+    n_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  const uint64_t n_chunks = (n_particles + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  n_threads = static_cast<size_t>(std::max<uint64_t>(
+      1, std::min<uint64_t>(n_threads, n_chunks)));
+
+  const size_t n_cells = problem_.GetGeometry().GetNumCells();
+  // chunks are summed in chunk order so the flux is the same whichever
+  // thread ran each chunk
+  OrderedTallyReduction reduction(
+      n_chunks, n_cells, OrderedTallyReduction::WINDOW_PER_THREAD * n_threads);
+  std::mutex error_mutex;
+  std::exception_ptr first_error;
+
+  auto worker = [&] {
+    try {
+      uint64_t chunk;
+      TransportTally* tally;
+      while (reduction.Next(chunk, tally)) {
+        const uint64_t end = std::min(n_particles, (chunk + 1) * CHUNK_SIZE);
+        for (uint64_t particle = chunk * CHUNK_SIZE; particle < end;
+             ++particle) {
+          Transport(particle, seed, *tally);
+        }
+        reduction.Finish(chunk);
+      }
+    } catch (...) {
+      {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!first_error) first_error = std::current_exception();
+      }
+      reduction.Abort();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t t = 1; t < n_threads; ++t) workers.emplace_back(worker);
+  worker();
+  for (auto& thread : workers) thread.join();
+
+  if (first_error) std::rethrow_exception(first_error);
+  return reduction.TakeResult();
+}
+
+void HistoryDriver::Transport(uint64_t particle, uint64_t seed,
+                              TransportTally& tally) const {
+  const Geometry& geometry = problem_.GetGeometry();
+  TransportRNG rng = ParticleRNG(seed, particle);
+
+  ++tally.histories;
+  const SourceSite site = problem_.SampleSource(rng);
+  std::optional<GeometryLocation> location =
+      geometry.Locate(site.position.ToPoint());
+  if (!location) {
+    ++tally.lost;
+    return;
+  }
+  Vec3 direction = site.direction;
+  const double energy = site.energy;
+  // the energy never changes, so neither does the majorant
+  const MajorantXS& majorant = problem_.GetMajorant();
+  const double majorant_xs = majorant.Empty() ? 0.0 : majorant.GetXS(energy);
+
+  uint64_t events = 0;
+  while (problem_.CountEvent(events)) {
+    const TransportMaterial* material = nullptr;
+
+    if (problem_.GetTracking(location->GetCell()) == TrackingMode::DELTA) {
+      // with nothing to collide with anywhere the flight ends outside
+      const double flight = SampleCollisionDistance(majorant_xs, rng);
+      if (flight == INF) {
+        ++tally.leaks;
+        return;
+      }
+      const Vec3 p = location->GetPosition() + flight * direction;
+      if (!geometry.Locate(p.ToPoint(), *location)) {
+        ++tally.leaks;
+        return;
+      }
+
+      const uint32_t cell = location->GetCell();
+      tally.flux[cell] += 1.0 / majorant_xs;
+      material = problem_.GetMaterial(geometry.GetCell(cell).material_id);
+      const double total_xs = material ? material->GetTotalXS(energy) : 0.0;
+      if (!AcceptDeltaCollision(total_xs, majorant_xs, Uniform(rng))) {
+        ++tally.virtual_collisions;
+        continue;
+      }
+    } else {
+      const uint32_t cell = location->GetCell();
+      material = problem_.GetMaterial(geometry.GetCell(cell).material_id);
+      const double total_xs = material ? material->GetTotalXS(energy) : 0.0;
+      const double collision = SampleCollisionDistance(total_xs, rng);
+      const GeometryCrossing crossing =
+          geometry.NextCrossing(*location, direction.ToDirection());
+
+      if (collision >= crossing.boundary.distance) {
+        // an unbounded void never ends
+        if (crossing.boundary.distance == INF) {
+          ++tally.lost;
+          return;
+        }
+
+        const double distance = crossing.boundary.distance;
+        tally.flux[cell] += distance;
+        ++tally.crossings;
+        const Vec3 p =
+            location->GetPosition() + (distance + BOUNDARY_NUDGE) * direction;
+        if (!geometry.Cross(*location, crossing, p.ToPoint())) {
+          ++tally.leaks;
+          return;
+        }
+        continue;
+      }
+
+      tally.flux[cell] += collision;
+      location->Move(direction, collision);
+    }
+
+    ++tally.collisions;
+    switch (SampleCollision(material->material->GetAllXS(energy), rng)) {
+      case CollisionType::SCATTER:
+        direction = SampleIsotropicDirection(rng);
+        break;
+      case CollisionType::CAPTURE:
+        ++tally.captures;
+        return;
+      case CollisionType::FISSION:
+        ++tally.fissions;
+        return;
+    }
+  }
+  ++tally.lost;
+}
+
+}  // namespace charmander
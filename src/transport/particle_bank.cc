@@ -0,0 +1,86 @@
+#include "transport/particle_bank.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace charmander {
+
+void ParticleBank::Reserve(size_t capacity) {
+  x.reserve(capacity);
+  y.reserve(capacity);
+  z.reserve(capacity);
+  u.reserve(capacity);
+  v.reserve(capacity);
+  w.reserve(capacity);
+  E.reserve(capacity);
+  weight.reserve(capacity);
+  cell.reserve(capacity);
+}
+
+void ParticleBank::Resize(size_t n) {
+  x.resize(n, 0.0);
+  y.resize(n, 0.0);
+  z.resize(n, 0.0);
+  u.resize(n, 0.0);
+  v.resize(n, 0.0);
+  w.resize(n, 0.0);
+  E.resize(n, 0.0);
+  weight.resize(n, 0.0);
+  cell.resize(n, NO_CELL);
+}
+
+size_t ParticleBank::Add(const Vec3& position, const Vec3& direction,
+                         double energy, double particle_weight,
+                         int32_t particle_cell) {
+  x.push_back(position.x);
+  y.push_back(position.y);
+  z.push_back(position.z);
+  u.push_back(direction.x);
+  v.push_back(direction.y);
+  w.push_back(direction.z);
+  E.push_back(energy);
+  weight.push_back(particle_weight);
+  cell.push_back(particle_cell);
+  return x.size() - 1;
+}
+
+void ParticleBank::Swap(size_t i, size_t j) {
+  std::swap(x[i], x[j]);
+  std::swap(y[i], y[j]);
+  std::swap(z[i], z[j]);
+  std::swap(u[i], u[j]);
+  std::swap(v[i], v[j]);
+  std::swap(w[i], w[j]);
+  std::swap(E[i], E[j]);
+  std::swap(weight[i], weight[j]);
+  std::swap(cell[i], cell[j]);
+}
+
+void ParticleBank::Advance(std::span<const double> distances) {
+  const size_t n = Size();
+  if (distances.size() != n) {
+    throw std::runtime_error("advancing " + std::to_string(n) +
+                             " particles by " +
+                             std::to_string(distances.size()) + " distances");
+  }
+
+  // restrict lets the compiler vectorize the three independent updates
+  double* __restrict px = x.data();
+  double* __restrict py = y.data();
+  double* __restrict pz = z.data();
+  const double* __restrict pu = u.data();
+  const double* __restrict pv = v.data();
+  const double* __restrict pw = w.data();
+  const double* __restrict dist = distances.data();
+  for (size_t i = 0; i < n; ++i) {
+    px[i] += dist[i] * pu[i];
+    py[i] += dist[i] * pv[i];
+    pz[i] += dist[i] * pw[i];
+  }
+}
+
+}  // namespace charmander
@@ -0,0 +1,153 @@
+#include "transport/philox.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+namespace charmander {
+
+namespace {
+// philox blocks generated side by side
+constexpr size_t LANES = 8;
+
+// LANES blocks at once, counters and keys stored word major so every round
+// is the same operation on whole rows
+struct PhiloxLanes {
+  alignas(32) uint32_t c[4][LANES];
+  alignas(32) uint32_t k[2][LANES];
+};
+
+#if defined(__AVX2__)
+// high and low halves of the 32 x 32 bit products of every lane with m
+inline void MulHiLo(__m256i a, __m256i m, __m256i& hi, __m256i& lo) {
+  const __m256i even = _mm256_mul_epu32(a, m);
+  const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+  lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+  hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+#endif
+
+void GenerateLanes(PhiloxLanes& lanes) {
+#if defined(__AVX2__)
+  static_assert(LANES == 8);
+  auto load = [](const uint32_t* row) {
+    return _mm256_load_si256(reinterpret_cast<const __m256i*>(row));
+  };
+  __m256i c0 = load(lanes.c[0]);
+  __m256i c1 = load(lanes.c[1]);
+  __m256i c2 = load(lanes.c[2]);
+  __m256i c3 = load(lanes.c[3]);
+  __m256i k0 = load(lanes.k[0]);
+  __m256i k1 = load(lanes.k[1]);
+  const __m256i m0 = _mm256_set1_epi32(static_cast<int>(PHILOX_M0));
+  const __m256i m1 = _mm256_set1_epi32(static_cast<int>(PHILOX_M1));
+  const __m256i w0 = _mm256_set1_epi32(static_cast<int>(PHILOX_W0));
+  const __m256i w1 = _mm256_set1_epi32(static_cast<int>(PHILOX_W1));
+  for (int round = 0; round < PHILOX_ROUNDS; ++round) {
+    __m256i hi0, lo0, hi1, lo1;
+    MulHiLo(c0, m0, hi0, lo0);
+    MulHiLo(c2, m1, hi1, lo1);
+    c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), k0);
+    c1 = lo1;
+    c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), k1);
+    c3 = lo0;
+    k0 = _mm256_add_epi32(k0, w0);
+    k1 = _mm256_add_epi32(k1, w1);
+  }
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes.c[0]), c0);
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes.c[1]), c1);
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes.c[2]), c2);
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes.c[3]), c3);
+#else
+  for (int round = 0; round < PHILOX_ROUNDS; ++round) {
+    for (size_t l = 0; l < LANES; ++l) {
+      const uint64_t p0 = uint64_t{PHILOX_M0} * lanes.c[0][l];
+      const uint64_t p1 = uint64_t{PHILOX_M1} * lanes.c[2][l];
+      const uint32_t c1 = lanes.c[1][l];
+      const uint32_t c3 = lanes.c[3][l];
+      lanes.c[0][l] = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ lanes.k[0][l];
+      lanes.c[1][l] = static_cast<uint32_t>(p1);
+      lanes.c[2][l] = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ lanes.k[1][l];
+      lanes.c[3][l] = static_cast<uint32_t>(p0);
+      lanes.k[0][l] += PHILOX_W0;
+      lanes.k[1][l] += PHILOX_W1;
+    }
+  }
+#endif
+}
+
+void SetLane(PhiloxLanes& lanes, size_t l, uint64_t batch, uint64_t particle,
+             uint64_t block) {
+  lanes.c[0][l] = static_cast<uint32_t>(block);
+  lanes.c[1][l] = static_cast<uint32_t>(block >> 32);
+  lanes.c[2][l] = static_cast<uint32_t>(batch);
+  lanes.c[3][l] = static_cast<uint32_t>(batch >> 32);
+  lanes.k[0][l] = static_cast<uint32_t>(particle);
+  lanes.k[1][l] = static_cast<uint32_t>(particle >> 32);
+}
+
+// draw word (0 or 1) of lane l, matching PhiloxStream
+uint64_t LaneWord(const PhiloxLanes& lanes, size_t l, uint64_t word) {
+  return word == 0 ? (uint64_t{lanes.c[1][l]} << 32 | lanes.c[0][l])
+                   : (uint64_t{lanes.c[3][l]} << 32 | lanes.c[2][l]);
+}
+}  // namespace
+
+void FillUniforms(uint64_t batch, uint64_t particle, uint64_t first,
+                  std::span<double> out) {
+  PhiloxLanes lanes;
+  size_t i = 0;
+  uint64_t position = first;
+  // an odd start takes the second word of its block on its own
+  if (i < out.size() && (position & 1)) {
+    out[i++] = ToUniform(PhiloxStream::Draw(batch, particle, position++));
+  }
+  while (i < out.size()) {
+    // each lane block holds the next two draws
+    const size_t n = std::min(2 * LANES, out.size() - i);
+    for (size_t l = 0; l < LANES; ++l) {
+      SetLane(lanes, l, batch, particle, (position >> 1) + l);
+    }
+    GenerateLanes(lanes);
+    for (size_t j = 0; j < n; ++j) {
+      out[i + j] = ToUniform(LaneWord(lanes, j >> 1, j & 1));
+    }
+    i += n;
+    position += n;
+  }
+}
+
+void NextUniforms(std::span<PhiloxStream> streams,
+                  std::span<const uint32_t> indices, std::span<double> out) {
+  if (indices.size() != out.size()) {
+    throw std::runtime_error("drawing " + std::to_string(indices.size()) +
+                             " uniforms into " + std::to_string(out.size()) +
+                             " outputs");
+  }
+
+  PhiloxLanes lanes;
+  for (size_t start = 0; start < indices.size(); start += LANES) {
+    const size_t n = std::min(LANES, indices.size() - start);
+    for (size_t l = 0; l < LANES; ++l) {
+      // idle lanes repeat the first stream, their output is dropped
+      const PhiloxStream& stream = streams[indices[start + (l < n ? l : 0)]];
+      SetLane(lanes, l, stream.GetBatch(), stream.GetParticle(),
+              stream.GetPosition() >> 1);
+    }
+    GenerateLanes(lanes);
+    for (size_t l = 0; l < n; ++l) {
+      PhiloxStream& stream = streams[indices[start + l]];
+      out[start + l] = ToUniform(LaneWord(lanes, l, stream.GetPosition() & 1));
+      stream.Skip(1);
+    }
+  }
+}
+
+}  // namespace charmander
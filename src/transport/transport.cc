@@ -0,0 +1,240 @@
+#include "transport/transport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <numbers>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "constants.h"
+
+namespace charmander {
+
+SourceSampler IsotropicPointSource(const Vec3& position, double energy) {
+  return [position, energy](TransportRNG& rng) {
+    return SourceSite{position, SampleIsotropicDirection(rng), energy};
+  };
+}
+
+Vec3 SampleIsotropicDirection(TransportRNG& rng) {
+  const double mu = 2.0 * Uniform(rng) - 1.0;
+  const double phi = 2.0 * std::numbers::pi * Uniform(rng);
+  const double sin_theta = std::sqrt(std::max(0.0, 1.0 - mu * mu));
+  return Vec3(sin_theta * std::cos(phi), sin_theta * std::sin(phi), mu);
+}
+
+double CollisionDistance(double total_xs, double xi) {
+  if (total_xs <= 0.0) return INF;
+  // 1 - xi is in (0, 1], keeping the log finite
+  return -std::log(1.0 - xi) / total_xs;
+}
+
+bool AcceptDeltaCollision(double total_xs, double majorant_xs, double xi) {
+  if (total_xs > majorant_xs) {
+    throw std::runtime_error("total xs " + std::to_string(total_xs) +
+                             " exceeds the majorant " +
+                             std::to_string(majorant_xs));
+  }
+  return xi * majorant_xs < total_xs;
+}
+
+CollisionType SampleCollision(const ReactionXS& xs, double xi) {
+  const double scatter = xs.xs[ELASTIC_CHANNEL] + xs.xs[INELASTIC_CHANNEL];
+  const double capture = xs.xs[CAPTURE_CHANNEL];
+  const double fission = xs.xs[FISSION_CHANNEL];
+  xi *= scatter + capture + fission;
+  if (xi < scatter) return CollisionType::SCATTER;
+  if (xi < scatter + capture) return CollisionType::CAPTURE;
+  return CollisionType::FISSION;
+}
+
+void TransportTally::Merge(const TransportTally& other) {
+  histories += other.histories;
+  collisions += other.collisions;
+  crossings += other.crossings;
+  captures += other.captures;
+  fissions += other.fissions;
+  leaks += other.leaks;
+  virtual_collisions += other.virtual_collisions;
+  lost += other.lost;
+  if (flux.size() < other.flux.size()) flux.resize(other.flux.size(), 0.0);
+  for (size_t i = 0; i < other.flux.size(); ++i) flux[i] += other.flux[i];
+}
+
+void TransportTally::Clear() {
+  histories = 0;
+  collisions = 0;
+  crossings = 0;
+  captures = 0;
+  fissions = 0;
+  leaks = 0;
+  virtual_collisions = 0;
+  lost = 0;
+  std::fill(flux.begin(), flux.end(), 0.0);
+}
+
+OrderedTallyReduction::OrderedTallyReduction(uint64_t n_items, size_t n_cells,
+                                             size_t window)
+    : slots_(std::max<size_t>(1, window), Slot{TransportTally(n_cells)}),
+      ready_(slots_.size(), 0),
+      result_(n_cells),
+      n_items_(n_items) {}
+
+bool OrderedTallyReduction::Next(uint64_t& item, TransportTally*& tally) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  // the slot of the next item is free once the item a window before it is
+  // summed
+  summed_.wait(lock, [&] {
+    return aborted_ || next_item_ >= n_items_ ||
+           next_item_ < n_summed_ + slots_.size();
+  });
+  if (aborted_ || next_item_ >= n_items_) return false;
+  item = next_item_++;
+  peak_pending_ = std::max(peak_pending_, next_item_ - n_summed_);
+  tally = &slots_[item % slots_.size()].tally;
+  return true;
+}
+
+void OrderedTallyReduction::Finish(uint64_t item) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  ready_[item % slots_.size()] = 1;
+  // the thread already summing picks this item up if it is next
+  if (summing_) return;
+  summing_ = true;
+  while (n_summed_ < n_items_ && ready_[n_summed_ % slots_.size()]) {
+    // the slot stays claimed until n_summed_ moves past it, so it can be
+    // summed and cleared without the lock
+    TransportTally& tally = slots_[n_summed_ % slots_.size()].tally;
+    lock.unlock();
+    result_.Merge(tally);
+    tally.Clear();
+    lock.lock();
+    ready_[n_summed_ % slots_.size()] = 0;
+    ++n_summed_;
+    summed_.notify_all();
+  }
+  summing_ = false;
+}
+
+void OrderedTallyReduction::Abort() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  aborted_ = true;
+  summed_.notify_all();
+}
+
+MajorantXS::MajorantXS(std::span<const TransportMaterial> materials) {
+  for (const TransportMaterial& material : materials) {
+    if (!material.material) continue;
+    for (const NuclideData& nucdata : material.material->GetNuclides()) {
+      const auto& energies = nucdata.nuc->GetEvaluationEnergies();
+      energies_.insert(energies_.end(), energies.begin(), energies.end());
+    }
+  }
+  std::sort(energies_.begin(), energies_.end());
+  energies_.erase(std::unique(energies_.begin(), energies_.end()),
+                  energies_.end());
+  if (energies_.size() < 2) {
+    throw std::runtime_error("majorant needs at least one material");
+  }
+
+  xs_.assign(energies_.size(), 0.0);
+  for (const TransportMaterial& material : materials) {
+    if (!material.material) continue;
+    for (size_t u = 0; u < energies_.size(); ++u) {
+      xs_[u] = std::max(xs_[u], material.GetTotalXS(energies_[u]));
+    }
+  }
+  for (double& xs : xs_) xs *= 1.0 + PADDING;
+}
+
+double MajorantXS::GetXS(double energy) const {
+  if (energy <= energies_.front()) return xs_.front();
+  if (energy >= energies_.back()) return xs_.back();
+
+  const size_t bin = static_cast<size_t>(
+      std::upper_bound(energies_.begin(), energies_.end(), energy) -
+      energies_.begin() - 1);
+  const double E_low = energies_[bin];
+  const double E_high = energies_[bin + 1];
+  return xs_[bin] +
+         (xs_[bin + 1] - xs_[bin]) * (energy - E_low) / (E_high - E_low);
+}
+
+TransportProblem::TransportProblem(const Geometry& geometry,
+                                   SourceSampler source)
+    : geometry_(geometry), source_(std::move(source)) {
+  if (!source_) throw std::runtime_error("transport problem needs a source");
+}
+
+void TransportProblem::SetMaterial(int material_id,
+                                   std::shared_ptr<const CEMaterial> material,
+                                   double atom_density) {
+  if (material_id < 0) {
+    throw std::runtime_error("negative material ids are void, got " +
+                             std::to_string(material_id));
+  }
+  if (!material || !(atom_density > 0.0)) {
+    throw std::runtime_error("material " + std::to_string(material_id) +
+                             " needs data and a positive atom density");
+  }
+  if (static_cast<size_t>(material_id) >= materials_.size()) {
+    materials_.resize(material_id + 1);
+  }
+  materials_[material_id] = {std::move(material), atom_density};
+  majorant_ = MajorantXS();
+}
+
+void TransportProblem::SetMaxEvents(uint64_t max_events) {
+  if (max_events == 0) {
+    throw std::runtime_error("a history needs at least one event");
+  }
+  max_events_ = max_events;
+}
+
+void TransportProblem::SetCellTracking(uint32_t cell, TrackingMode mode) {
+  if (cell >= geometry_.GetNumCells()) {
+    throw std::runtime_error("cannot set tracking of cell " +
+                             std::to_string(cell) + ", the geometry has " +
+                             std::to_string(geometry_.GetNumCells()));
+  }
+  if (cell_tracking_.size() < geometry_.GetNumCells()) {
+    cell_tracking_.resize(geometry_.GetNumCells(), default_tracking_);
+  }
+  cell_tracking_[cell] = mode;
+}
+
+bool TransportProblem::UsesDeltaTracking() const {
+  for (size_t i = 0; i < geometry_.GetNumCells(); ++i) {
+    if (geometry_.GetCell(i).fill == FillType::MATERIAL &&
+        GetTracking(static_cast<uint32_t>(i)) == TrackingMode::DELTA) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void TransportProblem::BuildMajorant() { majorant_ = MajorantXS(materials_); }
+
+void TransportProblem::Validate() const {
+  if (!geometry_.IsFinalized()) {
+    throw std::runtime_error("geometry must be finalized before transport");
+  }
+  for (size_t i = 0; i < geometry_.GetNumCells(); ++i) {
+    const Cell& cell = geometry_.GetCell(i);
+    if (cell.fill == FillType::MATERIAL && cell.material_id >= 0 &&
+        !GetMaterial(cell.material_id)) {
+      throw std::runtime_error("cell " + std::to_string(i) +
+                               " uses undefined material " +
+                               std::to_string(cell.material_id));
+    }
+  }
+  if (majorant_.Empty() && UsesDeltaTracking()) {
+    throw std::runtime_error(
+        "delta tracking needs BuildMajorant after the materials are set");
+  }
+}
+
+}  // namespace charmander
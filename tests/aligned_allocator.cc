@@ -0,0 +1,31 @@
+#include "aligned_allocator.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "constants.h"
+
+namespace charmander {
+
+TEST(AlignedAllocator, CacheLineAligned) {
+  for (size_t size : {1, 3, 17, 1000}) {
+    AlignedVector<float> data(size, 1.0f);
+    auto address = reinterpret_cast<std::uintptr_t>(data.data());
+    EXPECT_EQ(address % CACHE_LINE_BYTES, 0) << "size " << size;
+    EXPECT_FLOAT_EQ(data.back(), 1.0f);
+  }
+}
+
+TEST(AlignedAllocator, CustomAlignment) {
+  AlignedVector<double, 128> data(5);
+  auto address = reinterpret_cast<std::uintptr_t>(data.data());
+  EXPECT_EQ(address % 128, 0);
+
+  // reallocation keeps the alignment
+  data.resize(5000);
+  address = reinterpret_cast<std::uintptr_t>(data.data());
+  EXPECT_EQ(address % 128, 0);
+}
+
+}  // namespace charmander
@@ -4,6 +4,7 @@
 
 #include <cmath>
 #include <iostream>
+#include <type_traits>
 
 namespace charmander {
 
@@ -160,5 +161,33 @@ TEST(BasicTypes, FuzzyEqualDirection) {
   EXPECT_TRUE(fuzzyequal(d, e));
 }
 
-}  // namespace charmander
+TEST(BasicTypes, Vec3Conversions) {
+  Vec3 v(Point(1.0, 2.0, 3.0));
+  EXPECT_EQ(v.ToPoint(), Point(1.0, 2.0, 3.0));
+  v = Vec3(Direction(0.0, 1.0, 0.0));
+  EXPECT_EQ(v.ToDirection(), Direction(0.0, 1.0, 0.0));
+  EXPECT_EQ(Vec3(), Vec3(0.0, 0.0, 0.0));
+  // conversions are spelled out both ways
+  EXPECT_FALSE((std::is_convertible_v<Point, Vec3>));
+  EXPECT_FALSE((std::is_convertible_v<Direction, Vec3>));
+}
+
+TEST(BasicTypes, Vec3Arithmetic) {
+  Vec3 a(1.0, 2.0, 3.0);
+  const Vec3 b(1.0, 0.0, -1.0);
+  EXPECT_EQ(a + b, Vec3(2.0, 2.0, 2.0));
+  EXPECT_EQ(a - b, Vec3(0.0, 2.0, 4.0));
+  EXPECT_EQ(2.0 * b, Vec3(2.0, 0.0, -2.0));
+  EXPECT_DOUBLE_EQ(dot(a, b), -2.0);
+
+  a += b;
+  EXPECT_EQ(a, Vec3(2.0, 2.0, 2.0));
+  a *= 0.5;
+  EXPECT_EQ(a, Vec3(1.0, 1.0, 1.0));
 
+  std::ostringstream outputstream;
+  outputstream << a;
+  EXPECT_EQ(outputstream.str(), "Vec3(1, 1, 1)");
+}
+
+}  // namespace charmander
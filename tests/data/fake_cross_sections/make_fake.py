@@ -17,4 +17,16 @@ with h5py.File(out, "w") as f:
     xs_data = np.array([1.0, 2.0, 3.0], dtype=np.float64)
     dataset_str = "/FakeU235/reactions/reaction_{}/294K"
     for mt in ["002", "004", "018", "102"]:
-        f.require_group(dataset_str.format(mt)).create_dataset("xs", data=xs_data)
\ No newline at end of file
+        f.require_group(dataset_str.format(mt)).create_dataset("xs", data=xs_data)
+
+out = Path("FakeO16.h5")
+with h5py.File(out, "w") as f:
+    # offset, nonlinear grid so multi-nuclide lookups cant reuse FakeU235 bins
+    e = f.require_group("/FakeO16/energy")
+    e.create_dataset("294K", data=np.array([0.5, 1.5, 2.5], dtype=np.float64))
+    xs_data = np.array([10.0, 20.0, 50.0], dtype=np.float64)
+    dataset_str = "/FakeO16/reactions/reaction_{}/294K"
+    for mt in ["002", "018", "102"]:
+        f.require_group(dataset_str.format(mt)).create_dataset("xs", data=xs_data)
+    # threshold reaction, starts at the second energy
+    f.require_group(dataset_str.format("004")).create_dataset("xs", data=xs_data[1:])
@@ -0,0 +1,58 @@
+#include "geometry/bounding_box.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "basic_types.h"
+#include "constants.h"
+#include "geometry/cylinder.h"
+#include "geometry/plane.h"
+#include "geometry/surface_table.h"
+
+namespace charmander {
+TEST(BoundingBox, ContainsAndIntersects) {
+  BoundingBox box{0.0, 1.0, 0.0, 1.0, 0.0, 1.0};
+  EXPECT_TRUE(box.Contains({0.5, 0.5, 0.5}));
+  EXPECT_TRUE(box.Contains({1.0, 0.0, 0.5}));
+  EXPECT_FALSE(box.Contains({1.5, 0.5, 0.5}));
+
+  EXPECT_TRUE(box.Intersects({-1.0, 0.5, 0.5}, {1.0, 0.0, 0.0}));
+  EXPECT_FALSE(box.Intersects({-1.0, 0.5, 0.5}, {-1.0, 0.0, 0.0}));
+  EXPECT_FALSE(box.Intersects({-1.0, 0.5, 0.5}, {1.0, 0.0, 0.0}, 0.5));
+  EXPECT_FALSE(box.Intersects({-1.0, 2.0, 0.5}, {1.0, 0.0, 0.0}));
+  EXPECT_TRUE(box.Intersects({-1.0, -1.0, 0.5}, normalize({1.0, 1.0, 0.0})));
+
+  EXPECT_TRUE(BoundingBox::Empty().IsEmpty());
+  EXPECT_FALSE(BoundingBox().IsBounded());
+  BoundingBox merged = UnionBoxes(BoundingBox::Empty(), box);
+  EXPECT_DOUBLE_EQ(merged.x_max, 1.0);
+  EXPECT_TRUE(IntersectBoxes(box, {2.0, 3.0, 0.0, 1.0, 0.0, 1.0}).IsEmpty());
+}
+
+TEST(BoundingBox, HalfspaceBoundsAreConservative) {
+  Plane general(0.0, -2.0, 0.0, 1.0);  // -2 y >= 1 on the positive side
+  XPlane xplane(0.3);
+  Cylinder tilted(0.4, {0.0, 1.0, 1.0}, {0.1, 0.2, 0.3});
+  ZCylinder zcyl(0.6, {-0.2, 0.1, 0.0});
+
+  const BoundingBox pos_plane = HalfspaceBounds(general.Pack(), true);
+  EXPECT_NEAR(pos_plane.y_max, -0.5, 1e-8);
+  EXPECT_DOUBLE_EQ(pos_plane.y_min, -INF);
+  const BoundingBox tilted_box = HalfspaceBounds(tilted.Pack(), false);
+  EXPECT_DOUBLE_EQ(tilted_box.y_max, INF);
+  EXPECT_NEAR(tilted_box.x_max, 0.5, 1e-8);
+  EXPECT_FALSE(HalfspaceBounds(zcyl.Pack(), true).IsBounded());
+
+  const Surface* surfaces[] = {&general, &xplane, &tilted, &zcyl};
+  std::mt19937_64 rng(5);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  for (int n = 0; n < 1000; ++n) {
+    Point p(uniform(rng), uniform(rng), uniform(rng));
+    for (const Surface* surface : surfaces) {
+      const bool sense = surface->Sense(p);
+      EXPECT_TRUE(HalfspaceBounds(surface->Pack(), sense).Contains(p));
+    }
+  }
+}
+}  // namespace charmander
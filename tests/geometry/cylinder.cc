@@ -160,4 +160,33 @@ TEST(SurfacesCylinder, CylinderDistance) {
   EXPECT_DOUBLE_EQ(cyl.Distance(p, parallel), INF);
   EXPECT_DOUBLE_EQ(cyl.Distance(p, no_intersect), INF);
 }
-}  // namespace charmander
+
+TEST(SurfacesCylinder, AxisAlignedMatchesGeneral) {
+  Point c(0.2, -0.3, 0.4);
+  XCylinder xcyl(0.7, c);
+  YCylinder ycyl(0.7, c);
+  ZCylinder zcyl(0.7, c);
+  Cylinder xgeneral(0.7, {1.0, 0.0, 0.0}, c);
+  Cylinder ygeneral(0.7, {0.0, 1.0, 0.0}, c);
+  Cylinder zgeneral(0.7, {0.0, 0.0, 1.0}, c);
+  const Surface* fast[] = {&xcyl, &ycyl, &zcyl};
+  const Surface* general[] = {&xgeneral, &ygeneral, &zgeneral};
+
+  for (double t : {-1.0, -0.25, 0.0, 0.5, 2.0}) {
+    Point p(t, 0.5 * t - 0.1, 0.2 - t);
+    Direction d = normalize({0.3 - t, 0.2 + t, 0.5});
+    for (size_t i = 0; i < 3; ++i) {
+      EXPECT_NEAR(fast[i]->Evaluate(p), general[i]->Evaluate(p),
+                  FP_TOLERANCE);
+      EXPECT_EQ(fast[i]->Sense(p), general[i]->Sense(p));
+      EXPECT_TRUE(fuzzyequal(fast[i]->Normal(p), general[i]->Normal(p)));
+      const double expected = general[i]->Distance(p, d);
+      if (expected == INF) {
+        EXPECT_EQ(fast[i]->Distance(p, d), INF);
+      } else {
+        EXPECT_NEAR(fast[i]->Distance(p, d), expected, FP_TOLERANCE);
+      }
+    }
+  }
+}
+}  // namespace charmander
\ No newline at end of file
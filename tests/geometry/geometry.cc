@@ -1,9 +1,292 @@
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <deque>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "basic_types.h"
+#include "geometry/cylinder.h"
 #include "geometry/geometry.h"
+#include "geometry/lattice.h"
+#include "geometry/plane.h"
+#include "geometry/region.h"
+#include "geometry/universe.h"
 
 namespace charmander {
 
 TEST(Geometry, BasicConstructor) { EXPECT_NO_THROW(Geometry()); }
 
-}  // namespace charmander
\ No newline at end of file
+TEST(Geometry, FindCell) {
+  // 16 x 16 pin cells in [0, 16)^2, each a pin and its moderator, plus the
+  // outside of the lattice as a cell unbounded on every axis
+  const int n = 16;
+  std::deque<XPlane> xplanes;
+  std::deque<YPlane> yplanes;
+  std::deque<ZCylinder> pins;
+  for (int i = 0; i <= n; ++i) {
+    xplanes.emplace_back(i);
+    yplanes.emplace_back(i);
+  }
+
+  Geometry geometry;
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      const ZCylinder& pin = pins.emplace_back(0.4, Point(i + 0.5, j + 0.5, 0.0));
+      geometry.AddCell(Region({{-pin}}), 1);
+      geometry.AddCell(Region({{+pin, +xplanes[i], -xplanes[i + 1],
+                                +yplanes[j], -yplanes[j + 1]}}),
+                       2);
+    }
+  }
+  const size_t outside =
+      geometry.AddCell(-xplanes[0] | +xplanes[n] | -yplanes[0] | +yplanes[n], 0);
+
+  EXPECT_THROW(geometry.FindCell({0.5, 0.5, 0.0}), std::runtime_error);
+  geometry.Finalize();
+  EXPECT_TRUE(geometry.IsFinalized());
+  EXPECT_GT(geometry.GetNumBVHNodes(), 1);
+
+  EXPECT_EQ(geometry.FindCell({0.5, 0.5, 0.0}), 0);
+  EXPECT_EQ(geometry.FindCell({0.05, 0.05, 0.0}), 1);
+  EXPECT_EQ(geometry.FindCell({-1.0, 3.0, 0.0}), outside);
+  EXPECT_EQ(geometry.GetCell(*geometry.FindCell({3.5, 7.5, 2.0})).material_id, 1);
+
+  std::mt19937_64 rng(13);
+  std::uniform_real_distribution<double> uniform(-2.0, n + 2.0);
+  for (int k = 0; k < 2000; ++k) {
+    Point p(uniform(rng), uniform(rng), uniform(rng));
+    std::optional<size_t> expected;
+    for (size_t c = 0; c < geometry.GetNumCells(); ++c) {
+      if (geometry.GetCell(c).region.Contains(p)) {
+        expected = c;
+        break;
+      }
+    }
+    EXPECT_EQ(geometry.FindCell(p), expected) << p;
+  }
+}
+
+TEST(Geometry, FindCellMiss) {
+  ZCylinder pin(1.0, {0.0, 0.0, 0.0});
+  Geometry geometry;
+  geometry.AddCell(Region({{-pin}}), 1);
+  geometry.Finalize();
+  EXPECT_EQ(geometry.FindCell({0.0, 0.0, 0.0}), 0);
+  EXPECT_FALSE(geometry.FindCell({5.0, 0.0, 0.0}).has_value());
+
+  // adding a cell needs another Finalize
+  geometry.AddCell(Region({{+pin}}), 2);
+  EXPECT_FALSE(geometry.IsFinalized());
+}
+
+TEST(Geometry, LatticeOfUniverses) {
+  // a 4 x 4 lattice of one shared pin universe in [0, 4)^2, bounded by a
+  // root cell, compared against explicit pins
+  const int n = 4;
+  ZCylinder pin(0.4, {0.0, 0.0, 0.0});
+  XPlane left(0.0);
+  XPlane right(n);
+  YPlane bottom(0.0);
+  YPlane top(n);
+
+  Geometry geometry;
+  const uint32_t pin_universe = geometry.AddUniverse();
+  const size_t fuel = geometry.AddCell(pin_universe, Region({{-pin}}), 1);
+  const size_t moderator = geometry.AddCell(pin_universe, Region({{+pin}}), 2);
+  const uint32_t lattice = geometry.AddLattice(Lattice::Rectangular(
+      0.0, 0.0, 1.0, 1.0, n, n, std::vector<uint32_t>(n * n, pin_universe)));
+  const size_t core = geometry.AddFilledCell(
+      Geometry::ROOT_UNIVERSE, Region({{+left, -right, +bottom, -top}}),
+      FillType::LATTICE, lattice);
+  geometry.Finalize();
+  EXPECT_EQ(geometry.GetNumUniverses(), 2);
+
+  std::mt19937_64 rng(7);
+  std::uniform_real_distribution<double> uniform(0.0, n);
+  for (int k = 0; k < 500; ++k) {
+    Point p(uniform(rng), uniform(rng), 0.0);
+    const double dx = p.x - std::floor(p.x) - 0.5;
+    const double dy = p.y - std::floor(p.y) - 0.5;
+    const size_t expected = (dx * dx + dy * dy < 0.16) ? fuel : moderator;
+
+    auto location = geometry.Locate(p);
+    ASSERT_TRUE(location.has_value()) << p;
+    ASSERT_EQ(location->levels.size(), 2);
+    EXPECT_EQ(location->levels[0].cell, core);
+    EXPECT_EQ(location->levels[1].lattice, lattice);
+    EXPECT_EQ(location->levels[1].element,
+              static_cast<int>(std::floor(p.y)) * n + std::floor(p.x));
+    EXPECT_EQ(location->GetCell(), expected) << p;
+    EXPECT_EQ(geometry.FindCell(p), expected) << p;
+  }
+  EXPECT_FALSE(geometry.FindCell({-1.0, 1.0, 0.0}).has_value());
+
+  // from the center of element (1, 1) the pin is nearest, from the moderator
+  // the element edge is
+  auto center = geometry.Locate({1.5, 1.5, 0.0});
+  EXPECT_NEAR(geometry.Distance(*center, {1.0, 0.0, 0.0}), 0.4, 1e-9);
+  auto corner = geometry.Locate({1.05, 1.5, 0.0});
+  EXPECT_NEAR(geometry.Distance(*corner, {-1.0, 0.0, 0.0}), 0.05, 1e-9);
+  // from the edge of the core, the core boundary and element edge coincide
+  auto edge = geometry.Locate({3.95, 0.5, 0.0});
+  EXPECT_NEAR(geometry.Distance(*edge, {1.0, 0.0, 0.0}), 0.05, 1e-9);
+}
+
+TEST(Geometry, UniverseFill) {
+  ZCylinder inner(1.0, {0.0, 0.0, 0.0});
+  ZCylinder outer(2.0, {0.0, 0.0, 0.0});
+  Geometry geometry;
+  const uint32_t universe = geometry.AddUniverse();
+  const size_t a = geometry.AddCell(universe, Region({{-inner}}), 1);
+  const size_t b = geometry.AddCell(universe, Region({{+inner}}), 2);
+  geometry.AddFilledCell(Geometry::ROOT_UNIVERSE, Region({{-outer}}),
+                         FillType::UNIVERSE, universe);
+  geometry.Finalize();
+
+  EXPECT_EQ(geometry.FindCell({0.5, 0.0, 0.0}), a);
+  EXPECT_EQ(geometry.FindCell({1.5, 0.0, 0.0}), b);
+  EXPECT_FALSE(geometry.FindCell({2.5, 0.0, 0.0}).has_value());
+
+  // the filled universe is unbounded, the parent cell clips it
+  auto location = geometry.Locate({1.5, 0.0, 0.0});
+  EXPECT_NEAR(geometry.Distance(*location, {1.0, 0.0, 0.0}), 0.5, 1e-9);
+}
+
+TEST(Geometry, BadFill) {
+  ZCylinder pin(1.0, {0.0, 0.0, 0.0});
+  Geometry geometry;
+  geometry.AddFilledCell(Geometry::ROOT_UNIVERSE, Region({{-pin}}),
+                         FillType::LATTICE, 3);
+  EXPECT_THROW(geometry.Finalize(), std::runtime_error);
+
+  // a universe filling itself
+  Geometry loop;
+  loop.AddFilledCell(Geometry::ROOT_UNIVERSE, Region({{-pin}}),
+                     FillType::UNIVERSE, Geometry::ROOT_UNIVERSE);
+  loop.Finalize();
+  EXPECT_THROW(loop.FindCell({0.0, 0.0, 0.0}), std::runtime_error);
+  EXPECT_THROW(geometry.AddCell(5, Region({{-pin}}), 1), std::runtime_error);
+}
+
+// follows random rays crossing to crossing with Cross, checking every
+// location against a full Locate. returns the number of crossings
+int TrackRays(const Geometry& geometry, double lo, double hi, int n_rays,
+              uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> position(lo, hi);
+  std::uniform_real_distribution<double> angle(0.0, 2.0 * M_PI);
+  int n_crossings = 0;
+  for (int ray = 0; ray < n_rays; ++ray) {
+    const double phi = angle(rng);
+    const Direction d(std::cos(phi), std::sin(phi), 0.0);
+    double x = position(rng);
+    double y = position(rng);
+    GeometryLocation location;
+    bool inside = geometry.Locate({x, y, 0.0}, location);
+    while (inside) {
+      const GeometryCrossing crossing = geometry.NextCrossing(location, d);
+      if (crossing.boundary.distance == INF) break;
+      x += (crossing.boundary.distance + 1e-9) * d.x;
+      y += (crossing.boundary.distance + 1e-9) * d.y;
+      const Point p(x, y, 0.0);
+      inside = geometry.Cross(location, crossing, p);
+      auto expected = geometry.Locate(p);
+      EXPECT_EQ(inside, expected.has_value()) << p;
+      if (inside && expected) {
+        EXPECT_EQ(location.GetCell(), expected->GetCell()) << p;
+        EXPECT_EQ(location.levels.size(), expected->levels.size()) << p;
+        for (size_t j = 0; j < location.levels.size(); ++j) {
+          EXPECT_EQ(location.levels[j].element, expected->levels[j].element)
+              << p;
+          EXPECT_NEAR(location.levels[j].local.x,
+                      expected->levels[j].local.x, 1e-12) << p;
+          EXPECT_NEAR(location.levels[j].local.y,
+                      expected->levels[j].local.y, 1e-12) << p;
+        }
+      }
+      ++n_crossings;
+    }
+  }
+  return n_crossings;
+}
+
+TEST(Geometry, CrossPinGrid) {
+  const int n = 4;
+  std::deque<XPlane> xplanes;
+  std::deque<YPlane> yplanes;
+  std::deque<ZCylinder> pins;
+  for (int i = 0; i <= n; ++i) {
+    xplanes.emplace_back(i);
+    yplanes.emplace_back(i);
+  }
+  Geometry geometry;
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      const ZCylinder& pin = pins.emplace_back(0.4, Point(i + 0.5, j + 0.5, 0.0));
+      geometry.AddCell(Region({{-pin}}), 1);
+      geometry.AddCell(Region({{+pin, +xplanes[i], -xplanes[i + 1],
+                                +yplanes[j], -yplanes[j + 1]}}),
+                       2);
+    }
+  }
+  geometry.Finalize();
+
+  // pins and grid planes shared by neighbouring cells are stored once
+  EXPECT_EQ(geometry.GetSurfaceTable().Size(), n * n + 2 * (n + 1));
+
+  EXPECT_GT(TrackRays(geometry, 0.0, n, 200, 3), 200);
+
+  // crossing out of pin (0, 0) into its moderator was recorded
+  EXPECT_EQ(geometry.GetNeighbors(pins[0], true), std::vector<uint32_t>{1});
+  EXPECT_TRUE(geometry.GetNeighbors(pins[0], false).empty() ||
+              geometry.GetNeighbors(pins[0], false) ==
+                  std::vector<uint32_t>{0});
+  XPlane unused(-5.0);
+  EXPECT_TRUE(geometry.GetNeighbors(unused, true).empty());
+}
+
+TEST(Geometry, CrossLattice) {
+  const int n = 4;
+  ZCylinder pin(0.4, {0.0, 0.0, 0.0});
+  ZCylinder can(0.45, {0.0, 0.0, 0.0});
+  XPlane left(0.0);
+  XPlane right(n);
+  YPlane bottom(0.0);
+  YPlane top(n);
+
+  Geometry geometry;
+  const uint32_t pin_universe = geometry.AddUniverse();
+  geometry.AddCell(pin_universe, Region({{-pin}}), 1);
+  geometry.AddCell(pin_universe, Region({{+pin, -can}}), 2);
+  geometry.AddCell(pin_universe, Region({{+can}}), 3);
+  const uint32_t lattice = geometry.AddLattice(Lattice::Rectangular(
+      0.0, 0.0, 1.0, 1.0, n, n, std::vector<uint32_t>(n * n, pin_universe)));
+  geometry.AddFilledCell(Geometry::ROOT_UNIVERSE,
+                         Region({{+left, -right, +bottom, -top}}),
+                         FillType::LATTICE, lattice);
+  geometry.Finalize();
+
+  EXPECT_GT(TrackRays(geometry, 0.0, n, 200, 5), 200);
+
+  // the shared pin universe needs only one neighbor per side
+  EXPECT_EQ(geometry.GetNeighbors(pin, true).size(), 1);
+  EXPECT_EQ(geometry.GetNeighbors(can, true).size(), 1);
+
+  // an element edge is reported without a surface
+  auto location = geometry.Locate({1.05, 1.5, 0.0});
+  const GeometryCrossing crossing =
+      geometry.NextCrossing(*location, {-1.0, 0.0, 0.0});
+  EXPECT_NEAR(crossing.boundary.distance, 0.05, 1e-9);
+  EXPECT_EQ(crossing.boundary.surface, nullptr);
+  EXPECT_EQ(crossing.level, 1);
+  // crossing updates the location in its own storage
+  const GeometryLevel* storage = location->levels.data();
+  ASSERT_TRUE(geometry.Cross(*location, crossing, {0.95, 1.5, 0.0}));
+  EXPECT_EQ(location->levels[1].element, 1 * n + 0);
+  EXPECT_EQ(location->levels.data(), storage);
+}
+
+}  // namespace charmander
@@ -0,0 +1,97 @@
+#include "geometry/lattice.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "basic_types.h"
+#include "constants.h"
+
+namespace charmander {
+
+TEST(Lattice, RectangularElements) {
+  // 3 x 2 elements of 1 x 2 starting at (-1, 0)
+  Lattice lattice = Lattice::Rectangular(-1.0, 0.0, 1.0, 2.0, 3, 2,
+                                         {0, 1, 2, 3, 4, 5});
+  EXPECT_EQ(lattice.GetType(), LatticeType::RECTANGULAR);
+  EXPECT_EQ(lattice.GetNumElements(), 6);
+
+  EXPECT_EQ(lattice.GetElement(-0.5, 0.5), 0);
+  EXPECT_EQ(lattice.GetElement(1.5, 0.5), 2);
+  EXPECT_EQ(lattice.GetElement(0.5, 3.0), 4);
+  EXPECT_FALSE(lattice.GetElement(-1.5, 0.5).has_value());
+  EXPECT_FALSE(lattice.GetElement(0.5, 4.5).has_value());
+  EXPECT_EQ(lattice.GetUniverse(*lattice.GetElement(1.5, 3.5)), 5);
+
+  const auto [x, y] = lattice.GetCenter(4);
+  EXPECT_DOUBLE_EQ(x, 0.5);
+  EXPECT_DOUBLE_EQ(y, 3.0);
+}
+
+TEST(Lattice, RectangularElementDistance) {
+  Lattice lattice =
+      Lattice::Rectangular(0.0, 0.0, 1.0, 2.0, 2, 2, {0, 0, 0, 0});
+  EXPECT_NEAR(lattice.ElementDistance({0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}), 0.5,
+              1e-12);
+  EXPECT_NEAR(lattice.ElementDistance({0.25, 0.0, 0.0}, {-1.0, 0.0, 0.0}),
+              0.75, 1e-12);
+  EXPECT_NEAR(lattice.ElementDistance({0.0, 0.0, 0.0}, {0.0, -1.0, 0.0}), 1.0,
+              1e-12);
+  EXPECT_EQ(lattice.ElementDistance({0.0, 0.0, 0.0}, {0.0, 0.0, 1.0}), INF);
+}
+
+TEST(Lattice, HexagonalElements) {
+  // two rings, 7 hexagons in a 3 x 3 axial array
+  const double pitch = 2.0;
+  std::vector<uint32_t> universes(9);
+  for (uint32_t i = 0; i < 9; ++i) universes[i] = i;
+  Lattice lattice = Lattice::Hexagonal(0.0, 0.0, pitch, 2, universes);
+  EXPECT_EQ(lattice.GetType(), LatticeType::HEXAGONAL);
+
+  // the center hexagon is (q, r) = (0, 0), element 4
+  EXPECT_EQ(lattice.GetElement(0.0, 0.0), 4);
+  EXPECT_EQ(lattice.GetElement(0.9, 0.0), 4);
+  EXPECT_EQ(lattice.GetElement(1.1, 0.0), 5);
+  EXPECT_EQ(lattice.GetElement(-1.1, 0.0), 3);
+
+  // (q, r) = (0, 1) sits up and to the right
+  const auto [x, y] = lattice.GetCenter(7);
+  EXPECT_DOUBLE_EQ(x, 0.5 * pitch);
+  EXPECT_DOUBLE_EQ(y, 0.5 * std::sqrt(3.0) * pitch);
+  EXPECT_EQ(lattice.GetElement(x + 0.1, y - 0.1), 7);
+
+  // corners of the axial array are outside the rings
+  const auto [corner_x, corner_y] = lattice.GetCenter(8);
+  EXPECT_FALSE(lattice.GetElement(corner_x, corner_y).has_value());
+  EXPECT_FALSE(lattice.GetElement(5.0 * pitch, 0.0).has_value());
+
+  // every element center maps back to its element
+  for (size_t element : {1, 2, 3, 4, 5, 6, 7}) {
+    const auto [cx, cy] = lattice.GetCenter(element);
+    EXPECT_EQ(lattice.GetElement(cx, cy), element);
+  }
+}
+
+TEST(Lattice, HexagonalElementDistance) {
+  Lattice lattice = Lattice::Hexagonal(0.0, 0.0, 2.0, 1, {0});
+  // flat sides at x = +-1, corners at y = +-2 / sqrt(3)
+  EXPECT_NEAR(lattice.ElementDistance({0.0, 0.0, 0.0}, {1.0, 0.0, 0.0}), 1.0,
+              1e-12);
+  EXPECT_NEAR(lattice.ElementDistance({0.0, 0.0, 0.0}, {0.0, 1.0, 0.0}),
+              2.0 / std::sqrt(3.0), 1e-12);
+  EXPECT_NEAR(lattice.ElementDistance({0.5, 0.0, 0.0}, {-1.0, 0.0, 0.0}), 1.5,
+              1e-12);
+}
+
+TEST(Lattice, Validation) {
+  EXPECT_THROW(Lattice::Rectangular(0.0, 0.0, 1.0, 1.0, 2, 2, {0, 0, 0}),
+               std::runtime_error);
+  EXPECT_THROW(Lattice::Rectangular(0.0, 0.0, 0.0, 1.0, 1, 1, {0}),
+               std::runtime_error);
+  EXPECT_THROW(Lattice::Hexagonal(0.0, 0.0, 1.0, 0, {}), std::runtime_error);
+}
+
+}  // namespace charmander
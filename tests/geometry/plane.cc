@@ -102,4 +102,26 @@ TEST(SurfacesPlane, PlaneDistance) {
   EXPECT_DOUBLE_EQ(plane.Distance(p, parallel), INF);
   EXPECT_DOUBLE_EQ(plane.Distance(p, null), INF);
 }
+
+TEST(SurfacesPlane, AxisAlignedMatchesGeneral) {
+  XPlane xplane(0.3);
+  YPlane yplane(-0.2);
+  ZPlane zplane(0.1);
+  Plane xgeneral(1.0, 0.0, 0.0, 0.3);
+  Plane ygeneral(0.0, 1.0, 0.0, -0.2);
+  Plane zgeneral(0.0, 0.0, 1.0, 0.1);
+  const Surface* fast[] = {&xplane, &yplane, &zplane};
+  const Surface* general[] = {&xgeneral, &ygeneral, &zgeneral};
+
+  for (double t : {-1.0, -0.25, 0.0, 0.5, 2.0}) {
+    Point p(t, 0.5 * t - 0.1, 0.2 - t);
+    Direction d = normalize({0.3 - t, 0.2 + t, 0.5});
+    for (size_t i = 0; i < 3; ++i) {
+      EXPECT_DOUBLE_EQ(fast[i]->Evaluate(p), general[i]->Evaluate(p));
+      EXPECT_EQ(fast[i]->Sense(p), general[i]->Sense(p));
+      EXPECT_EQ(fast[i]->Normal(p), general[i]->Normal(p));
+      EXPECT_DOUBLE_EQ(fast[i]->Distance(p, d), general[i]->Distance(p, d));
+    }
+  }
+}
 }  // namespace charmander
\ No newline at end of file
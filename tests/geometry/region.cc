@@ -1,4 +1,6 @@
 #include <gtest/gtest.h>
+#include <memory>
+#include <random>
 #include <stdexcept>
 
 #include "basic_types.h"
@@ -7,6 +9,7 @@
 #include "geometry/surface.h"
 #include "geometry/cylinder.h"
 #include "geometry/plane.h"
+#include "geometry/surface_table.h"
 
 namespace charmander
 {
@@ -66,6 +69,66 @@ namespace charmander
     EXPECT_EQ(&(reg->GetClauses().front().front().GetSurface()),&cyl);
   }
 
+  TEST(Region, FlatStorage) {
+    ZCylinder cyl(1.0, {0.0, 0.0, 0.0});
+    ZPlane top(5.0);
+    ZPlane bottom(-5.0);
+
+    Region reg({{-cyl, -top, +bottom}, {+top}, {-bottom, +cyl}});
+    EXPECT_EQ(reg.GetNumClauses(), 3);
+    EXPECT_EQ(reg.GetSurfaceTable().Size(), 3);
+
+    // clauses come back as built
+    const auto clauses = reg.GetClauses();
+    ASSERT_EQ(clauses.size(), 3);
+    ASSERT_EQ(clauses[0].size(), 3);
+    ASSERT_EQ(clauses[1].size(), 1);
+    ASSERT_EQ(clauses[2].size(), 2);
+    EXPECT_EQ(&clauses[0][0].GetSurface(), &cyl);
+    EXPECT_FALSE(clauses[0][0].IsPositive());
+    EXPECT_EQ(&clauses[0][2].GetSurface(), &bottom);
+    EXPECT_TRUE(clauses[0][2].IsPositive());
+    EXPECT_EQ(&clauses[1][0].GetSurface(), &top);
+    EXPECT_EQ(&clauses[2][1].GetSurface(), &cyl);
+    EXPECT_TRUE(clauses[2][1].IsPositive());
+
+    // the old layout held a vector per clause of 16 byte halfspaces. the
+    // flat one is smaller apart from the clause boxes it adds
+    const size_t nested = 3 * sizeof(std::vector<Halfspace>) + 6 * sizeof(Halfspace);
+    EXPECT_LT(reg.GetMemoryBytes() - 3 * sizeof(BoundingBox), nested);
+
+    // a single clause keeps no clause box, a pin cell is smaller outright
+    XPlane left(-1.0);
+    XPlane right(1.0);
+    Region pin_cell({{+cyl, +left, -right, -top, +bottom}});
+    EXPECT_LT(pin_cell.GetMemoryBytes(), sizeof(std::vector<Halfspace>) + 5 * sizeof(Halfspace));
+  }
+
+  TEST(Region, ShareSurfaceTable) {
+    ZCylinder cyl(1.0, {0.0, 0.0, 0.0});
+    ZPlane top(5.0);
+    ZPlane bottom(-5.0);
+    Region inside({{-cyl, -top, +bottom}});
+    Region outside({{+cyl, -top, +bottom}});
+
+    auto table = std::make_shared<SurfaceTable>();
+    inside.ShareSurfaceTable(table);
+    outside.ShareSurfaceTable(table);
+    // each surface stored once for both regions
+    EXPECT_EQ(table->Size(), 3);
+    EXPECT_EQ(&inside.GetSurfaceTable(), table.get());
+    EXPECT_EQ(outside.GetNumSurfaces(), 3);
+
+    EXPECT_TRUE(inside.Contains({0.0, 0.0, 0.0}));
+    EXPECT_FALSE(outside.Contains({0.0, 0.0, 0.0}));
+    EXPECT_TRUE(outside.Contains({2.0, 0.0, 0.0}));
+    const BoundaryCrossing crossing = inside.NextCrossing({0.0, 0.0, 0.0}, {1.0, 0.0, 0.0});
+    EXPECT_DOUBLE_EQ(crossing.distance, 1.0);
+    EXPECT_EQ(crossing.surface, &cyl);
+    EXPECT_EQ(&table->GetSurface(crossing.surface_index), &cyl);
+    EXPECT_TRUE(crossing.sense);
+  }
+
   TEST(Region, Contains) {
     Cylinder cyl(1.0, {0, 0, 1}, {0.0, 0.0, 0.0});
     ZPlane top(5.0);
@@ -129,4 +192,263 @@ namespace charmander
     EXPECT_DOUBLE_EQ(inreg.Distance(outside_below, up_in), 5.0/3.0);
     EXPECT_DOUBLE_EQ(outreg.Distance(outside_below, up_in), 5.0/3.0);
   }
+
+  TEST(Region, DistanceSecondCrossing) {
+    ZCylinder cyl(1.0, {0.0, 0.0, 0.0});
+    XPlane plane(0.5);
+    Region reg({{+cyl, +plane}});
+
+    // enters the cylinder, crosses the plane inside it, and only enters the
+    // region on leaving the cylinder again
+    Point start(-2.0, 0.0, 0.0);
+    Direction x_up(1.0, 0.0, 0.0);
+    EXPECT_DOUBLE_EQ(reg.Distance(start, x_up), 3.0);
+  }
+
+  TEST(Region, NextCrossing) {
+    ZCylinder cyl(1.0, {0.0, 0.0, 0.0});
+    XPlane plane(0.5);
+    Region reg({{+cyl, +plane}});
+
+    // the region is entered through the positive side of the cylinder
+    BoundaryCrossing crossing = reg.NextCrossing({-2.0, 0.0, 0.0}, {1.0, 0.0, 0.0});
+    EXPECT_DOUBLE_EQ(crossing.distance, 3.0);
+    EXPECT_EQ(crossing.surface, &cyl);
+    EXPECT_TRUE(crossing.sense);
+
+    // and left through the negative side of the cylinder or the plane
+    crossing = reg.NextCrossing({2.0, 0.0, 0.0}, {-1.0, 0.0, 0.0});
+    EXPECT_DOUBLE_EQ(crossing.distance, 1.0);
+    EXPECT_EQ(crossing.surface, &cyl);
+    EXPECT_FALSE(crossing.sense);
+    crossing = reg.NextCrossing({0.75, 2.0, 0.0}, {-1.0, 0.0, 0.0});
+    EXPECT_DOUBLE_EQ(crossing.distance, 0.25);
+    EXPECT_EQ(crossing.surface, &plane);
+    EXPECT_FALSE(crossing.sense);
+
+    crossing = reg.NextCrossing({2.0, 0.0, 0.0}, {1.0, 0.0, 0.0});
+    EXPECT_EQ(crossing.distance, INF);
+    EXPECT_EQ(crossing.surface, nullptr);
+
+    CSGRegion csg = +cyl & +plane;
+    crossing = csg.NextCrossing({0.75, 2.0, 0.0}, {-1.0, 0.0, 0.0});
+    EXPECT_DOUBLE_EQ(crossing.distance, 0.25);
+    EXPECT_EQ(crossing.surface, &plane);
+    EXPECT_FALSE(crossing.sense);
+  }
+
+  TEST(Region, DistanceFromSurface) {
+    ZCylinder cyl(1.0, {0.0, 0.0, 0.0});
+    ZPlane top(5.0);
+    ZPlane bottom(-5.0);
+    Region inreg({{-cyl, -top, +bottom}});
+
+    // sitting on the top surface moving in, the next crossing is the exit
+    Point on_top(0.0, 0.0, 5.0);
+    EXPECT_DOUBLE_EQ(inreg.Distance(on_top, {0.0, 0.0, -1.0}), 10.0);
+    EXPECT_DOUBLE_EQ(inreg.Distance(on_top, {0.0, 0.0, 1.0}), INF);
+  }
+
+  TEST(Region, DistanceChangesContainment) {
+    ZCylinder fuel(0.4, {0.0, 0.0, 0.0});
+    ZCylinder clad(0.5, {0.0, 0.0, 0.0});
+    XPlane left(-0.6);
+    XPlane right(0.6);
+    YPlane front(-0.6);
+    YPlane back(0.6);
+    Cylinder tilted(0.3, {1.0, 1.0, 1.0}, {0.2, 0.0, 0.0});
+    Region reg = (+clad & +left & -right & +front & -back) | -fuel | (-tilted & +right);
+
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    const double eps = 1e-9;
+    for (int n = 0; n < 500; ++n)
+    {
+      Point p(uniform(rng), uniform(rng), uniform(rng));
+      Direction d = normalize({uniform(rng), uniform(rng), uniform(rng)});
+      const bool start_in = reg.Contains(p);
+      const double dist = reg.Distance(p, d);
+      if (dist == INF) continue;
+      EXPECT_EQ(reg.Contains(p + (dist - eps) * d), start_in);
+      EXPECT_NE(reg.Contains(p + (dist + eps) * d), start_in);
+    }
+  }
+
+  TEST(Region, Compile) {
+    Cylinder tilted(0.5, {1.0, 1.0, 0.0}, {0.0, 0.0, 0.0});
+    ZCylinder cyl(1.0, {0.0, 0.0, 0.0});
+    ZPlane top(5.0);
+    ZPlane bottom(-5.0);
+    XPlane x0(0.0);
+
+    Region reg({
+        {-cyl, -top, -cyl, +bottom},     // duplicate -cyl
+        {+x0, -x0, -top},                // never holds
+        {-cyl, -top, +bottom, +tilted},  // implied by the first clause
+        {+tilted, -top},
+    });
+    Region original = reg;
+    reg.Compile();
+
+    ASSERT_EQ(reg.GetNumClauses(), 2);
+    const auto clauses = reg.GetClauses();
+    // plane tests come before cylinders, the cheaper clause first
+    ASSERT_EQ(clauses[0].size(), 3);
+    EXPECT_EQ(&clauses[0][0].GetSurface(), &top);
+    EXPECT_EQ(&clauses[0][1].GetSurface(), &bottom);
+    EXPECT_EQ(&clauses[0][2].GetSurface(), &cyl);
+    ASSERT_EQ(clauses[1].size(), 2);
+    EXPECT_EQ(&clauses[1][0].GetSurface(), &top);
+    EXPECT_EQ(&clauses[1][1].GetSurface(), &tilted);
+    // x0 is no longer referenced
+    EXPECT_EQ(reg.GetNumSurfaces(), 4);
+
+    std::mt19937_64 rng(3);
+    std::uniform_real_distribution<double> uniform(-6.0, 6.0);
+    for (int n = 0; n < 500; ++n)
+    {
+      Point p(uniform(rng) / 4, uniform(rng) / 4, uniform(rng));
+      Direction d = normalize({uniform(rng), uniform(rng), uniform(rng)});
+      EXPECT_EQ(reg.Contains(p), original.Contains(p));
+      EXPECT_DOUBLE_EQ(reg.Distance(p, d), original.Distance(p, d));
+    }
+  }
+
+  TEST(Region, CompileEmpty) {
+    ZPlane top(5.0);
+    Region reg({{+top, -top}});
+    reg.Compile();
+    EXPECT_EQ(reg.GetNumClauses(), 1);
+    EXPECT_FALSE(reg.Contains({0.0, 0.0, 0.0}));
+    EXPECT_FALSE(reg.Contains({0.0, 0.0, 10.0}));
+    EXPECT_DOUBLE_EQ(reg.Distance({0.0, 0.0, 0.0}, {0.0, 0.0, 1.0}), INF);
+  }
+
+  TEST(Region, BoundingBox) {
+    ZCylinder pin(0.5, {1.0, 2.0, 0.0});
+    ZPlane top(5.0);
+    ZPlane bottom(-5.0);
+    XPlane left(-3.0);
+
+    Region bounded({{-pin, -top, +bottom}});
+    const BoundingBox& box = bounded.GetBoundingBox();
+    EXPECT_TRUE(box.IsBounded());
+    EXPECT_NEAR(box.x_min, 0.5, 1e-8);
+    EXPECT_NEAR(box.x_max, 1.5, 1e-8);
+    EXPECT_NEAR(box.y_min, 1.5, 1e-8);
+    EXPECT_NEAR(box.y_max, 2.5, 1e-8);
+    EXPECT_DOUBLE_EQ(box.z_min, -5.0);
+    EXPECT_DOUBLE_EQ(box.z_max, 5.0);
+
+    // the union is only bounded where every clause is
+    Region open({{-pin, -top, +bottom}, {-left, +bottom}});
+    EXPECT_FALSE(open.GetBoundingBox().IsBounded());
+    EXPECT_DOUBLE_EQ(open.GetBoundingBox().x_min, -INF);
+    EXPECT_NEAR(open.GetBoundingBox().x_max, 1.5, 1e-8);
+    EXPECT_DOUBLE_EQ(open.GetBoundingBox().z_min, -5.0);
+    EXPECT_DOUBLE_EQ(open.GetBoundingBox().z_max, INF);
+
+    // rejected by the box, and rays missing it never enter
+    EXPECT_FALSE(bounded.Contains({5.0, 5.0, 0.0}));
+    EXPECT_DOUBLE_EQ(bounded.Distance({5.0, 5.0, 0.0}, {1.0, 0.0, 0.0}), INF);
+    EXPECT_DOUBLE_EQ(bounded.Distance({3.0, 2.0, 0.0}, {-1.0, 0.0, 0.0}), 1.5);
+
+    CSGRegion csg = CSGRegion(-pin) & (-top & +bottom);
+    EXPECT_NEAR(csg.GetBoundingBox().x_max, 1.5, 1e-8);
+    EXPECT_DOUBLE_EQ(csg.GetBoundingBox().z_max, 5.0);
+  }
+
+  TEST(CSGRegion, MatchesRegion) {
+    ZCylinder fuel(0.4, {0.0, 0.0, 0.0});
+    XPlane left(-0.6);
+    XPlane right(0.6);
+    YPlane front(-0.6);
+    YPlane back(0.6);
+    ZPlane top(0.5);
+
+    Region dnf = (+fuel | -left | +right) & (-front | +back | -top);
+    CSGRegion csg = CSGRegion(+fuel | -left | +right) & (-front | +back | -top);
+    CSGRegion converted(dnf);
+
+    std::mt19937_64 rng(11);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    for (int n = 0; n < 500; ++n)
+    {
+      Point p(uniform(rng), uniform(rng), uniform(rng));
+      Direction d = normalize({uniform(rng), uniform(rng), uniform(rng)});
+      EXPECT_EQ(csg.Contains(p), dnf.Contains(p));
+      EXPECT_EQ(converted.Contains(p), dnf.Contains(p));
+      EXPECT_DOUBLE_EQ(csg.Distance(p, d), dnf.Distance(p, d));
+    }
+  }
+
+  TEST(CSGRegion, NoClauseExplosion) {
+    std::vector<ZPlane> planes;
+    planes.reserve(20);
+    for (int i = 0; i < 20; ++i) planes.emplace_back(0.1 * i);
+
+    // ten two-term unions intersected: 2^10 clauses as DNF
+    Region dnf = +planes[0] | -planes[1];
+    CSGRegion csg = +planes[0] | -planes[1];
+    for (size_t i = 2; i < planes.size(); i += 2)
+    {
+      dnf = dnf & (+planes[i] | -planes[i + 1]);
+      csg = csg & (+planes[i] | -planes[i + 1]);
+    }
+    EXPECT_EQ(dnf.GetClauses().size(), 1024);
+    // 20 halfspaces, 10 unions, 9 intersections
+    EXPECT_EQ(csg.GetNumNodes(), 39);
+    EXPECT_EQ(csg.GetSurfaceTable().Size(), 20);
+
+    for (double z : {-0.05, 0.05, 0.55, 1.25, 2.0})
+    {
+      EXPECT_EQ(csg.Contains({0.0, 0.0, z}), dnf.Contains({0.0, 0.0, z}));
+    }
+  }
+
+  TEST(CSGRegion, DeepTree) {
+    // a long chain evaluates without recursing once per node
+    ZPlane plane(0.0);
+    const size_t n = 300000;
+    CSGRegion all(Region({std::vector<Halfspace>(n, +plane)}));
+    CSGRegion any(Region(std::vector<std::vector<Halfspace>>(n, {+plane})));
+    EXPECT_EQ(all.GetNumNodes(), 2 * n - 1);
+    EXPECT_EQ(any.GetNumNodes(), 2 * n - 1);
+    EXPECT_TRUE(all.Contains({0.0, 0.0, 1.0}));
+    EXPECT_FALSE(all.Contains({0.0, 0.0, -1.0}));
+    EXPECT_TRUE(any.Contains({0.0, 0.0, 1.0}));
+    EXPECT_FALSE(any.Contains({0.0, 0.0, -1.0}));
+
+    // right deep, each left operand a single halfspace
+    std::vector<ZPlane> planes;
+    for (int i = 0; i < 8; ++i) planes.emplace_back(0.1 * i);
+    CSGRegion nested = -planes[7];
+    Region dnf({{-planes[7]}});
+    for (int i = 6; i >= 0; --i)
+    {
+      if (i % 2 == 0) {
+        nested = CSGRegion(+planes[i]) & nested;
+        dnf = +planes[i] & dnf;
+      } else {
+        nested = CSGRegion(-planes[i]) | nested;
+        dnf = -planes[i] | dnf;
+      }
+    }
+    for (int k = -2; k < 10; ++k)
+    {
+      const Point p(0.0, 0.0, 0.1 * k + 0.05);
+      EXPECT_EQ(nested.Contains(p), dnf.Contains(p)) << p;
+      EXPECT_DOUBLE_EQ(nested.Distance(p, {0.0, 0.0, 1.0}),
+                       dnf.Distance(p, {0.0, 0.0, 1.0}));
+    }
+  }
+
+  TEST(CSGRegion, Distance) {
+    ZCylinder cyl(1.0, {0.0, 0.0, 0.0});
+    XPlane plane(0.5);
+    CSGRegion reg = CSGRegion(+cyl) & +plane;
+    EXPECT_DOUBLE_EQ(reg.Distance({-2.0, 0.0, 0.0}, {1.0, 0.0, 0.0}), 3.0);
+    EXPECT_DOUBLE_EQ(reg.Distance({3.0, 0.0, 0.0}, {1.0, 0.0, 0.0}), INF);
+    EXPECT_DOUBLE_EQ(reg.Distance({3.0, 0.0, 0.0}, {-1.0, 0.0, 0.0}), 2.0);
+  }
 } // namespace charmander
@@ -0,0 +1,81 @@
+#include "geometry/surface_table.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "basic_types.h"
+#include "constants.h"
+#include "geometry/cylinder.h"
+#include "geometry/plane.h"
+#include "geometry/surface.h"
+
+namespace charmander {
+TEST(SurfaceTable, AddDeduplicates) {
+  XPlane xplane(1.0);
+  ZCylinder zcyl(0.5, {1.0, 2.0, 0.0});
+
+  SurfaceTable table;
+  EXPECT_EQ(table.Add(xplane), 0);
+  EXPECT_EQ(table.Add(zcyl), 1);
+  EXPECT_EQ(table.Add(xplane), 0);
+  EXPECT_EQ(table.Size(), 2);
+
+  EXPECT_EQ(table[0].type, SurfaceType::X_PLANE);
+  EXPECT_DOUBLE_EQ(table[0].coeffs[0], 1.0);
+  EXPECT_EQ(table[1].type, SurfaceType::Z_CYLINDER);
+  EXPECT_DOUBLE_EQ(table[1].coeffs[0], 0.25);
+  EXPECT_DOUBLE_EQ(table[1].coeffs[1], 1.0);
+  EXPECT_DOUBLE_EQ(table[1].coeffs[2], 2.0);
+}
+
+TEST(SurfaceTable, MatchesVirtualSurfaces) {
+  std::vector<std::unique_ptr<Surface>> surfaces;
+  surfaces.push_back(std::make_unique<Plane>(1.0, -2.0, 0.5, 0.3));
+  surfaces.push_back(std::make_unique<XPlane>(0.2));
+  surfaces.push_back(std::make_unique<YPlane>(-0.4));
+  surfaces.push_back(std::make_unique<ZPlane>(0.7));
+  surfaces.push_back(std::make_unique<Cylinder>(
+      0.8, Direction(1.0, 1.0, 0.5), Point(0.1, -0.2, 0.3)));
+  surfaces.push_back(std::make_unique<XCylinder>(0.6, Point(0.0, 0.1, 0.2)));
+  surfaces.push_back(std::make_unique<YCylinder>(0.6, Point(-0.3, 0.0, 0.2)));
+  surfaces.push_back(std::make_unique<ZCylinder>(0.6, Point(0.3, -0.1, 0.0)));
+
+  SurfaceTable table;
+  for (const auto& surface : surfaces) table.Add(*surface);
+
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> uniform(-1.5, 1.5);
+  for (int n = 0; n < 200; ++n) {
+    Point p(uniform(rng), uniform(rng), uniform(rng));
+    Direction d = normalize({uniform(rng), uniform(rng), uniform(rng)});
+    for (size_t i = 0; i < surfaces.size(); ++i) {
+      EXPECT_NEAR(table.Evaluate(i, p), surfaces[i]->Evaluate(p),
+                  FP_TOLERANCE);
+      EXPECT_EQ(table.Sense(i, p), surfaces[i]->Sense(p));
+      const double expected = surfaces[i]->Distance(p, d);
+      if (expected == INF) {
+        EXPECT_EQ(table.Distance(i, p, d), INF);
+      } else {
+        EXPECT_NEAR(table.Distance(i, p, d), expected, 1e-9);
+      }
+    }
+  }
+}
+
+TEST(SurfaceTable, AxisAlignedParallel) {
+  XPlane xplane(1.0);
+  ZCylinder zcyl(1.0, {0.0, 0.0, 0.0});
+  SurfaceTable table;
+  table.Add(xplane);
+  table.Add(zcyl);
+
+  Point origin(0.0, 0.0, 0.0);
+  EXPECT_EQ(table.Distance(0, origin, {0.0, 1.0, 0.0}), INF);
+  EXPECT_EQ(table.Distance(1, origin, {0.0, 0.0, 1.0}), INF);
+  EXPECT_DOUBLE_EQ(table.Distance(0, origin, {1.0, 0.0, 0.0}), 1.0);
+  EXPECT_DOUBLE_EQ(table.Distance(1, origin, {0.0, -1.0, 0.0}), 1.0);
+}
+}  // namespace charmander
@@ -14,6 +14,7 @@ namespace charmander {
 class MaterialsCEMaterial : public test_helpers::CharmanderXSEnvWrapper, public ::testing::Test {
  protected:
   std::shared_ptr<Nuclide> nuc_obj_;
+  std::shared_ptr<Nuclide> offset_nuc_obj_;
   void SetUp() override {
     overwrite();
     const char* gotten = std::getenv(charmander_xs_.c_str());
@@ -21,6 +22,8 @@ class MaterialsCEMaterial : public test_helpers::CharmanderXSEnvWrapper, public
 
     nuc_obj_ = std::make_shared<Nuclide>(nuclide_);
     nuc_obj_->LoadFromFile();
+    offset_nuc_obj_ = std::make_shared<Nuclide>("FakeO16");
+    offset_nuc_obj_->LoadFromFile();
   }
 
   void TearDown() override {
@@ -65,13 +68,13 @@ TEST_F(MaterialsCEMaterial, CEMaterialGetTotalXS) {
   }
 
   // energies are 0, 1, 2
-  // total xs is 1, 2, 3
+  // each partial xs is 1, 2, 3, so the total is 4, 8, 12
   // under clip
-  EXPECT_DOUBLE_EQ(mat.GetTotalXS(-0.5), 1.0);
-  EXPECT_DOUBLE_EQ(mat.GetTotalXS(0.0), 1.0);
-  EXPECT_DOUBLE_EQ(mat.GetTotalXS(0.5), 1.5);
+  EXPECT_DOUBLE_EQ(mat.GetTotalXS(-0.5), 4.0);
+  EXPECT_DOUBLE_EQ(mat.GetTotalXS(0.0), 4.0);
+  EXPECT_DOUBLE_EQ(mat.GetTotalXS(0.5), 6.0);
   // // over clip
-  EXPECT_DOUBLE_EQ(mat.GetTotalXS(3.0), 3.0);
+  EXPECT_DOUBLE_EQ(mat.GetTotalXS(3.0), 12.0);
 }
 
 TEST_F(MaterialsCEMaterial, CEMaterialGetXSFromMT) {
@@ -93,4 +96,131 @@ EXPECT_DOUBLE_EQ(mat.GetXSFromMT(MT::FISSION, 0.5), 1.5);
 // // over clip
 EXPECT_DOUBLE_EQ(mat.GetXSFromMT(MT::CAPTURE, 3.0), 3.0); 
 }
-}
\ No newline at end of file
+
+TEST_F(MaterialsCEMaterial, CEMaterialUnionGrid) {
+  NuclideData nucdatum1(nuc_obj_, 0.5);
+  NuclideData nucdatum2(offset_nuc_obj_, 0.5);
+  CEMaterial mat(1, {nucdatum1, nucdatum2});
+
+  // FakeU235 energies are 0, 1, 2 and FakeO16 energies are 0.5, 1.5, 2.5
+  std::vector<double> expected{0.0, 0.5, 1.0, 1.5, 2.0, 2.5};
+  EXPECT_EQ(mat.GetUnionEnergies(), expected);
+
+  EXPECT_EQ(mat.GetUnionEnergyBin(-1.0), 0);
+  EXPECT_EQ(mat.GetUnionEnergyBin(0.5), 1);
+  EXPECT_EQ(mat.GetUnionEnergyBin(1.25), 2);
+  EXPECT_EQ(mat.GetUnionEnergyBin(3.0), 4);
+}
+
+TEST_F(MaterialsCEMaterial, CEMaterialMultiNuclideXS) {
+  NuclideData nucdatum1(nuc_obj_, 0.5);
+  NuclideData nucdatum2(offset_nuc_obj_, 0.5);
+  CEMaterial mat(1, {nucdatum1, nucdatum2});
+
+  // FakeU235 xs is 1, 2, 3 on 0, 1, 2
+  // FakeO16 xs is 10, 20, 50 on 0.5, 1.5, 2.5
+  // totals sum the four partials, FakeO16 inelastic is 0 below 1.5, so
+  // FakeU235 totals are 4, 8, 12 and FakeO16 totals are 30, 80, 200
+  // below both grids, each nuclide clips to its first point
+  EXPECT_DOUBLE_EQ(mat.GetTotalXS(0.0), 0.5 * 4.0 + 0.5 * 30.0);
+  // each nuclide must interpolate in its own bin
+  EXPECT_DOUBLE_EQ(mat.GetTotalXS(1.25), 0.5 * 9.0 + 0.5 * 67.5);
+  EXPECT_DOUBLE_EQ(mat.GetTotalXS(2.25), 0.5 * 12.0 + 0.5 * 170.0);
+  EXPECT_DOUBLE_EQ(mat.GetXSFromMT(MT::FISSION, 1.25), 0.5 * 2.25 + 0.5 * 17.5);
+  // above both grids
+  EXPECT_DOUBLE_EQ(mat.GetXSFromMT(MT::CAPTURE, 3.0), 0.5 * 3.0 + 0.5 * 50.0);
+}
+
+TEST_F(MaterialsCEMaterial, CEMaterialEnergySearch) {
+  NuclideData nucdatum1(nuc_obj_, 0.5);
+  NuclideData nucdatum2(offset_nuc_obj_, 0.5);
+  CEMaterial mat_union(1, {nucdatum1, nucdatum2}, EnergySearch::UNION_GRID);
+  CEMaterial mat_hash(1, {nucdatum1, nucdatum2}, EnergySearch::HASH);
+  CEMaterial mat_binary(1, {nucdatum1, nucdatum2}, EnergySearch::BINARY);
+
+  // only the union grid material carries a union grid
+  EXPECT_FALSE(mat_union.GetUnionEnergies().empty());
+  EXPECT_TRUE(mat_hash.GetUnionEnergies().empty());
+  EXPECT_GT(mat_union.GetSearchMemoryBytes(), 0);
+  EXPECT_GT(mat_hash.GetSearchMemoryBytes(), 0);
+  EXPECT_EQ(mat_binary.GetSearchMemoryBytes(), 0);
+
+  for (double energy = -0.5; energy <= 3.0; energy += 0.125) {
+    const double expected = mat_binary.GetTotalXS(energy);
+    EXPECT_DOUBLE_EQ(mat_union.GetTotalXS(energy), expected) << "energy " << energy;
+    EXPECT_DOUBLE_EQ(mat_hash.GetTotalXS(energy), expected) << "energy " << energy;
+    EXPECT_DOUBLE_EQ(mat_hash.GetXSFromMT(MT::FISSION, energy),
+                     mat_binary.GetXSFromMT(MT::FISSION, energy));
+  }
+}
+
+TEST_F(MaterialsCEMaterial, CEMaterialPrecomputeTotalXS) {
+  NuclideData nucdatum1(nuc_obj_, 0.5);
+  NuclideData nucdatum2(offset_nuc_obj_, 0.5);
+  CEMaterial mat_summed(1, {nucdatum1, nucdatum2}, EnergySearch::HASH);
+  CEMaterial mat_table(1, {nucdatum1, nucdatum2}, EnergySearch::HASH);
+
+  EXPECT_FALSE(mat_table.HasTotalXSTable());
+  EXPECT_EQ(mat_table.GetTotalXSTableMemoryBytes(), 0);
+  mat_table.PrecomputeTotalXS();
+  EXPECT_TRUE(mat_table.HasTotalXSTable());
+  // 6 union energies and 6 totals
+  EXPECT_EQ(mat_table.GetTotalXSTableMemoryBytes(), 12 * sizeof(double));
+
+  for (double energy = -0.5; energy <= 3.0; energy += 0.125) {
+    EXPECT_DOUBLE_EQ(mat_table.GetTotalXS(energy), mat_summed.GetTotalXS(energy))
+        << "energy " << energy;
+  }
+
+  // the union grid search already owns the grid, only the table is extra
+  CEMaterial mat_union(1, {nucdatum1, nucdatum2}, EnergySearch::UNION_GRID);
+  mat_union.PrecomputeTotalXS();
+  EXPECT_EQ(mat_union.GetTotalXSTableMemoryBytes(), 6 * sizeof(double));
+  EXPECT_DOUBLE_EQ(mat_union.GetTotalXS(1.25), 0.5 * 9.0 + 0.5 * 67.5);
+}
+
+TEST_F(MaterialsCEMaterial, CEMaterialGetAllXS) {
+  NuclideData nucdatum1(nuc_obj_, 0.25);
+  NuclideData nucdatum2(offset_nuc_obj_, 0.75);
+  CEMaterial mat(1, {nucdatum1, nucdatum2});
+
+  for (double energy = -0.5; energy <= 3.0; energy += 0.125) {
+    ReactionXS all = mat.GetAllXS(energy);
+    EXPECT_DOUBLE_EQ(all.Total(), mat.GetTotalXS(energy));
+    // the total is the sum of the partial channels
+    EXPECT_NEAR(mat.GetTotalXS(energy),
+                all.FromMT(MT::ELASTIC) + all.FromMT(MT::INELASTIC) +
+                    all.FromMT(MT::FISSION) + all.FromMT(MT::CAPTURE),
+                1e-12 * mat.GetTotalXS(energy));
+    for (MT mt : {MT::ELASTIC, MT::INELASTIC, MT::FISSION, MT::CAPTURE}) {
+      EXPECT_DOUBLE_EQ(all.FromMT(mt), mat.GetXSFromMT(mt, energy))
+          << "mt " << mt << " energy " << energy;
+    }
+  }
+}
+
+TEST_F(MaterialsCEMaterial, CEMaterialBatchedGetTotalXS) {
+  NuclideData nucdatum1(nuc_obj_, 0.25);
+  NuclideData nucdatum2(offset_nuc_obj_, 0.75);
+  CEMaterial mat(1, {nucdatum1, nucdatum2});
+
+  std::vector<double> energies;
+  for (size_t i = 0; i < 600; ++i) energies.push_back(-0.5 + 3.5 * i / 599.0);
+  std::vector<double> xs(energies.size());
+
+  mat.GetTotalXS(energies, xs);
+  for (size_t i = 0; i < energies.size(); ++i) {
+    EXPECT_DOUBLE_EQ(xs[i], mat.GetTotalXS(energies[i])) << "energy " << energies[i];
+  }
+
+  // table path
+  mat.PrecomputeTotalXS();
+  mat.GetTotalXS(energies, xs);
+  for (size_t i = 0; i < energies.size(); ++i) {
+    EXPECT_DOUBLE_EQ(xs[i], mat.GetTotalXS(energies[i])) << "energy " << energies[i];
+  }
+
+  std::vector<double> too_short(energies.size() - 1);
+  EXPECT_THROW(mat.GetTotalXS(energies, too_short), std::runtime_error);
+}
+}
@@ -4,6 +4,11 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
 namespace charmander {
 
 class MaterialsNuclide : public test_helpers::CharmanderXSEnvWrapper, public ::testing::Test {
@@ -21,6 +26,17 @@ class MaterialsNuclide : public test_helpers::CharmanderXSEnvWrapper, public ::t
 
 TEST_F(MaterialsNuclide, Constructor) { EXPECT_NO_THROW(Nuclide nuc(nuclide_)); }
 
+TEST_F(MaterialsNuclide, Temperature) {
+  Nuclide nuc(nuclide_);
+  EXPECT_EQ(nuc.GetTemperature(), "294K");
+
+  // fake library only has 294K data
+  Nuclide hot(nuclide_, "600K");
+  EXPECT_EQ(hot.GetTemperature(), "600K");
+  EXPECT_THROW(hot.LoadFromFile(), std::runtime_error);
+  EXPECT_FALSE(hot.AlreadyLoaded());
+}
+
 TEST_F(MaterialsNuclide, LoadFromFile) {
   Nuclide nuc(nuclide_);
   EXPECT_FALSE(nuc.AlreadyLoaded());
@@ -41,24 +57,55 @@ TEST_F(MaterialsNuclide, GetLowerEnergyBin) {
   EXPECT_EQ(nuc.GetLowerEnergyBin(2.0 + FP_TOLERANCE), 1);
 }
 
+TEST_F(MaterialsNuclide, BinarySearchEnergyBin) {
+  Nuclide nuc(nuclide_);
+  nuc.LoadFromFile();
+
+  // energies are 0, 1, 2
+  EXPECT_EQ(nuc.BinarySearchEnergyBin(0.0 - FP_TOLERANCE), 0);
+  EXPECT_EQ(nuc.BinarySearchEnergyBin(0.5), 0);
+  EXPECT_EQ(nuc.BinarySearchEnergyBin(1.5), 1);
+  EXPECT_EQ(nuc.BinarySearchEnergyBin(2.0 + FP_TOLERANCE), 1);
+}
+
+TEST_F(MaterialsNuclide, EnergyHashMatchesBinarySearch) {
+  Nuclide nuc(nuclide_);
+  nuc.LoadFromFile();
+  EXPECT_GT(nuc.GetEnergyHashMemoryBytes(), 0);
+
+  // sweep across and past the grid, including exact grid points
+  for (double energy = -0.5; energy <= 2.5; energy += 0.125) {
+    EXPECT_EQ(nuc.GetLowerEnergyBin(energy), nuc.BinarySearchEnergyBin(energy))
+        << "energy " << energy;
+  }
+
+  Nuclide offset_nuc("FakeO16");
+  offset_nuc.LoadFromFile();
+  for (double energy = 0.0; energy <= 3.0; energy += 0.125) {
+    EXPECT_EQ(offset_nuc.GetLowerEnergyBin(energy),
+              offset_nuc.BinarySearchEnergyBin(energy))
+        << "energy " << energy;
+  }
+}
+
 TEST_F(MaterialsNuclide, GetTotalXS) {
   Nuclide nuc(nuclide_);
   nuc.LoadFromFile();
 
   // energies are 0, 1, 2
-  // total xs is 1, 2, 3
+  // each partial xs is 1, 2, 3, so the total is 4, 8, 12
 
-  // expect 1.0 (min) because we clip at boundaries
+  // expect 4.0 (min) because we clip at boundaries
   size_t under_energy = nuc.GetLowerEnergyBin(-1.0);
-  EXPECT_DOUBLE_EQ(nuc.GetTotalXS(under_energy, -1.0), 1.0);
+  EXPECT_DOUBLE_EQ(nuc.GetTotalXS(under_energy, -1.0), 4.0);
 
-  // expect 1.5 from linear interpolation
+  // expect 6.0 from linear interpolation
   size_t norm_energy = nuc.GetLowerEnergyBin(0.5);
-  EXPECT_DOUBLE_EQ(nuc.GetTotalXS(norm_energy, 0.5), 1.5);
+  EXPECT_DOUBLE_EQ(nuc.GetTotalXS(norm_energy, 0.5), 6.0);
 
-  // expect 3.0 (max) because we clip at boundaries
+  // expect 12.0 (max) because we clip at boundaries
   size_t over_energy = nuc.GetLowerEnergyBin(2.5);
-  EXPECT_DOUBLE_EQ(nuc.GetTotalXS(over_energy, 2.5), 3.0);
+  EXPECT_DOUBLE_EQ(nuc.GetTotalXS(over_energy, 2.5), 12.0);
 }
 
 TEST_F(MaterialsNuclide, GetXSFromMT) {
@@ -83,4 +130,147 @@ TEST_F(MaterialsNuclide, GetXSFromMT) {
   size_t over_energy = nuc.GetLowerEnergyBin(2.5);
   EXPECT_DOUBLE_EQ(nuc.GetXSFromMT(MT::ELASTIC, over_energy, 2.5), 3.0);
 }
+
+TEST_F(MaterialsNuclide, InterleavedXSRecord) {
+  Nuclide nuc(nuclide_);
+  nuc.LoadFromFile();
+
+  // one aligned record per energy point
+  EXPECT_EQ(nuc.GetXSTableMemoryBytes(),
+            nuc.GetEvaluationEnergies().size() * XS_RECORD_STRIDE * sizeof(float));
+  auto address = reinterpret_cast<std::uintptr_t>(nuc.GetXSRecord(0));
+  EXPECT_EQ(address % CACHE_LINE_BYTES, 0);
+
+  // energies are 0, 1, 2
+  // all xs is 1, 2, 3, the total sums the four partials
+  const float* record = nuc.GetXSRecord(1);
+  EXPECT_FLOAT_EQ(record[TOTAL_CHANNEL], 8.0f);
+  EXPECT_FLOAT_EQ(record[ELASTIC_CHANNEL], 2.0f);
+  EXPECT_FLOAT_EQ(record[INELASTIC_CHANNEL], 2.0f);
+  EXPECT_FLOAT_EQ(record[FISSION_CHANNEL], 2.0f);
+  EXPECT_FLOAT_EQ(record[CAPTURE_CHANNEL], 2.0f);
+
+  size_t norm_energy = nuc.GetLowerEnergyBin(0.5);
+  EXPECT_DOUBLE_EQ(nuc.GetXSFromMT(MT::TOTAL, norm_energy, 0.5),
+                   nuc.GetTotalXS(norm_energy, 0.5));
+  EXPECT_THROW(nuc.GetXSFromMT(static_cast<MT>(16), norm_energy, 0.5),
+               std::out_of_range);
+}
+
+TEST_F(MaterialsNuclide, GetAllXS) {
+  Nuclide nuc(nuclide_);
+  nuc.LoadFromFile();
+
+  // energies are 0, 1, 2
+  // all xs is 1, 2, 3
+  for (double energy : {-1.0, 0.0, 0.5, 1.0, 1.75, 2.0, 2.5}) {
+    size_t bin = nuc.GetLowerEnergyBin(energy);
+    ReactionXS all = nuc.GetAllXS(bin, energy);
+    EXPECT_DOUBLE_EQ(all.Total(), nuc.GetTotalXS(bin, energy));
+    for (MT mt : {MT::ELASTIC, MT::INELASTIC, MT::FISSION, MT::CAPTURE}) {
+      EXPECT_DOUBLE_EQ(all.FromMT(mt), nuc.GetXSFromMT(mt, bin, energy))
+          << "mt " << mt << " energy " << energy;
+    }
+  }
+}
+
+TEST_F(MaterialsNuclide, BatchedGetTotalXS) {
+  Nuclide nuc(nuclide_);
+  nuc.LoadFromFile();
+
+  // more energies than one batch pass, including clipped ones
+  std::vector<double> energies;
+  for (size_t i = 0; i < 600; ++i) energies.push_back(-0.5 + 3.0 * i / 599.0);
+  std::vector<double> xs(energies.size());
+  nuc.GetTotalXS(energies, xs);
+  for (size_t i = 0; i < energies.size(); ++i) {
+    size_t bin = nuc.GetLowerEnergyBin(energies[i]);
+    EXPECT_DOUBLE_EQ(xs[i], nuc.GetTotalXS(bin, energies[i]))
+        << "energy " << energies[i];
+  }
+
+  std::vector<double> too_short(energies.size() - 1);
+  EXPECT_THROW(nuc.GetTotalXS(energies, too_short), std::runtime_error);
+}
+
+TEST_F(MaterialsNuclide, ThresholdReaction) {
+  Nuclide nuc(nuclide_);
+  nuc.LoadFromFile();
+  EXPECT_EQ(nuc.GetThresholdIndex(MT::INELASTIC), 0);
+
+  // energies are 0.5, 1.5, 2.5
+  // inelastic is only tabulated from 1.5 as 20, 50
+  Nuclide offset_nuc("FakeO16");
+  offset_nuc.LoadFromFile();
+  EXPECT_EQ(offset_nuc.GetThresholdIndex(MT::INELASTIC), 1);
+  EXPECT_EQ(offset_nuc.GetThresholdIndex(MT::ELASTIC), 0);
+
+  for (double energy : {0.0, 0.5}) {
+    size_t bin = offset_nuc.GetLowerEnergyBin(energy);
+    EXPECT_DOUBLE_EQ(offset_nuc.GetXSFromMT(MT::INELASTIC, bin, energy), 0.0);
+  }
+  // rises from zero at the last point below threshold
+  size_t bin = offset_nuc.GetLowerEnergyBin(1.0);
+  EXPECT_DOUBLE_EQ(offset_nuc.GetXSFromMT(MT::INELASTIC, bin, 1.0), 10.0);
+  bin = offset_nuc.GetLowerEnergyBin(2.0);
+  EXPECT_DOUBLE_EQ(offset_nuc.GetXSFromMT(MT::INELASTIC, bin, 2.0), 35.0);
+  EXPECT_DOUBLE_EQ(offset_nuc.GetAllXS(bin, 2.0).FromMT(MT::INELASTIC), 35.0);
+}
+
+TEST_F(MaterialsNuclide, LazyChannelLoad) {
+  Nuclide nuc("FakeO16");
+  nuc.LoadFromFile(ChannelMaskFromMTs({MT::ELASTIC}));
+  EXPECT_TRUE(nuc.AlreadyLoaded());
+  EXPECT_TRUE(nuc.IsChannelLoaded(MT::ELASTIC));
+  EXPECT_FALSE(nuc.IsChannelLoaded(MT::INELASTIC));
+  EXPECT_FALSE(nuc.IsChannelLoaded(MT::TOTAL));
+
+  // channels left out are read on first access
+  Nuclide eager("FakeO16");
+  eager.LoadFromFile();
+  size_t bin = nuc.GetLowerEnergyBin(2.0);
+  EXPECT_DOUBLE_EQ(nuc.GetXSFromMT(MT::INELASTIC, bin, 2.0),
+                   eager.GetXSFromMT(MT::INELASTIC, bin, 2.0));
+  EXPECT_TRUE(nuc.IsChannelLoaded(MT::INELASTIC));
+  EXPECT_EQ(nuc.GetThresholdIndex(MT::INELASTIC), 1);
+  EXPECT_FALSE(nuc.IsChannelLoaded(MT::FISSION));
+
+  // the total needs every partial
+  EXPECT_DOUBLE_EQ(nuc.GetTotalXS(bin, 2.0), eager.GetTotalXS(bin, 2.0));
+  for (MT mt : {MT::TOTAL, MT::ELASTIC, MT::INELASTIC, MT::FISSION,
+                MT::CAPTURE}) {
+    EXPECT_TRUE(nuc.IsChannelLoaded(mt));
+  }
+
+  // requiring the total reads everything up front
+  Nuclide total_only("FakeO16");
+  total_only.LoadFromFile(ChannelMaskFromMTs({MT::TOTAL}));
+  EXPECT_TRUE(total_only.IsChannelLoaded(MT::CAPTURE));
+
+  Nuclide unloaded("FakeO16");
+  EXPECT_THROW(unloaded.GetXSFromMT(MT::ELASTIC, 0, 1.0), std::runtime_error);
+}
+
+TEST_F(MaterialsNuclide, ConcurrentLazyChannelLoad) {
+  Nuclide eager("FakeO16");
+  eager.LoadFromFile();
+  Nuclide nuc("FakeO16");
+  nuc.LoadFromFile(0);
+
+  std::vector<double> results(8);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < results.size(); ++t) {
+    threads.emplace_back([&, t] {
+      size_t bin = nuc.GetLowerEnergyBin(2.0);
+      results[t] = nuc.GetAllXS(bin, 2.0).Total() +
+                   nuc.GetXSFromMT(MT::CAPTURE, bin, 2.0);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  size_t bin = eager.GetLowerEnergyBin(2.0);
+  const double expected = eager.GetAllXS(bin, 2.0).Total() +
+                          eager.GetXSFromMT(MT::CAPTURE, bin, 2.0);
+  for (double result : results) EXPECT_DOUBLE_EQ(result, expected);
+}
 }  // namespace charmander
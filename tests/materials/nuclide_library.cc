@@ -0,0 +1,92 @@
+#include "materials/nuclide_library.h"
+#include "env_wrapper.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "materials/nuclide.h"
+
+namespace charmander {
+
+class MaterialsNuclideLibrary : public test_helpers::CharmanderXSEnvWrapper,
+                                public ::testing::Test {
+ protected:
+  void SetUp() override { overwrite(); }
+
+  void TearDown() override { reinstate(); }
+};
+
+TEST_F(MaterialsNuclideLibrary, GetSharesNuclides) {
+  NuclideLibrary library;
+  EXPECT_FALSE(library.Contains(nuclide_));
+
+  auto first = library.Get(nuclide_);
+  auto second = library.Get(nuclide_);
+  EXPECT_TRUE(first->AlreadyLoaded());
+  EXPECT_EQ(first.get(), second.get());
+  EXPECT_TRUE(library.Contains(nuclide_));
+  EXPECT_EQ(library.Size(), 1);
+
+  auto other = library.Get("FakeO16");
+  EXPECT_NE(other.get(), first.get());
+  EXPECT_EQ(library.Size(), 2);
+}
+
+TEST_F(MaterialsNuclideLibrary, KeyedByTemperature) {
+  NuclideLibrary library;
+  library.Get(nuclide_, "294K");
+  // fake library only has 294K data
+  EXPECT_THROW(library.Get(nuclide_, "600K"), std::runtime_error);
+  EXPECT_FALSE(library.Contains(nuclide_, "600K"));
+  // failed loads are retried, and fail again
+  EXPECT_THROW(library.Get(nuclide_, "600K"), std::runtime_error);
+  EXPECT_TRUE(library.Contains(nuclide_, "294K"));
+  EXPECT_EQ(library.Size(), 1);
+}
+
+TEST_F(MaterialsNuclideLibrary, ConcurrentGet) {
+  NuclideLibrary library;
+  std::vector<std::shared_ptr<const Nuclide>> results(8);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < results.size(); ++t) {
+    threads.emplace_back([&, t] {
+      results[t] = library.Get(t % 2 ? nuclide_ : std::string("FakeO16"));
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  for (size_t t = 0; t < results.size(); ++t) {
+    ASSERT_TRUE(results[t]->AlreadyLoaded());
+    EXPECT_EQ(results[t].get(), results[t % 2].get());
+  }
+  EXPECT_EQ(library.Size(), 2);
+}
+
+TEST_F(MaterialsNuclideLibrary, LoadAll) {
+  NuclideLibrary library;
+  library.LoadAll({nuclide_, "FakeO16", nuclide_}, "294K", 4);
+  EXPECT_TRUE(library.Contains(nuclide_));
+  EXPECT_TRUE(library.Contains("FakeO16"));
+  EXPECT_EQ(library.Size(), 2);
+
+  // the good nuclide still loads when another one fails
+  NuclideLibrary partial;
+  EXPECT_THROW(partial.LoadAll({"not_real", nuclide_}, "294K", 2),
+               std::runtime_error);
+  EXPECT_TRUE(partial.Contains(nuclide_));
+  EXPECT_FALSE(partial.Contains("not_real"));
+}
+
+TEST_F(MaterialsNuclideLibrary, RequiredChannels) {
+  NuclideLibrary library;
+  library.LoadAll({"FakeO16"}, "294K", 1, ChannelMaskFromMTs({MT::FISSION}));
+  auto nuc = library.Get("FakeO16");
+  EXPECT_TRUE(nuc->IsChannelLoaded(MT::FISSION));
+  EXPECT_FALSE(nuc->IsChannelLoaded(MT::ELASTIC));
+}
+
+}  // namespace charmander
@@ -0,0 +1,164 @@
+#include "materials/xs_cache.h"
+#include "env_wrapper.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "constants.h"
+#include "materials/nuclide.h"
+
+namespace charmander {
+
+class MaterialsXSCache : public test_helpers::CharmanderXSEnvWrapper,
+                         public ::testing::Test {
+ protected:
+  std::filesystem::path cache_dir_;
+  bool has_cache_env_{false};
+  std::string old_cache_env_;
+
+  void SetUp() override {
+    overwrite();
+    // restored in TearDown so a failing test cannot leak its cache dir
+    if (const char* var = std::getenv("CHARMANDER_XS_CACHE")) {
+      has_cache_env_ = true;
+      old_cache_env_ = var;
+    }
+    cache_dir_ = std::filesystem::temp_directory_path() /
+                 ("charmander_xs_cache_" +
+                  std::string(::testing::UnitTest::GetInstance()
+                                  ->current_test_info()
+                                  ->name()));
+    std::filesystem::create_directories(cache_dir_);
+  }
+
+  void TearDown() override {
+    if (has_cache_env_) {
+      SetCacheEnv(old_cache_env_);
+    } else {
+      UnsetCacheEnv();
+    }
+    std::filesystem::remove_all(cache_dir_);
+    reinstate();
+  }
+
+  static void SetCacheEnv(const std::string& value) {
+#ifdef _WIN32
+    _putenv_s("CHARMANDER_XS_CACHE", value.c_str());
+#else
+    setenv("CHARMANDER_XS_CACHE", value.c_str(), 1);
+#endif
+  }
+
+  static void UnsetCacheEnv() {
+#ifdef _WIN32
+    _putenv("CHARMANDER_XS_CACHE=");
+#else
+    unsetenv("CHARMANDER_XS_CACHE");
+#endif
+  }
+
+  std::string WriteCache(const std::string& nuclide) {
+    Nuclide nuc(nuclide);
+    nuc.LoadFromHDF5();
+    std::string path =
+        (cache_dir_ / XSCache::CacheFileName(nuclide, "294K")).string();
+    nuc.WriteXSCache(path);
+    return path;
+  }
+};
+
+TEST_F(MaterialsXSCache, RoundTrip) {
+  for (const std::string& name : {nuclide_, std::string("FakeO16")}) {
+    std::string path = WriteCache(name);
+
+    Nuclide from_hdf5(name);
+    from_hdf5.LoadFromHDF5();
+    Nuclide from_cache(name);
+    from_cache.LoadFromXSCache(path);
+
+    EXPECT_FALSE(from_hdf5.IsMapped());
+    EXPECT_TRUE(from_cache.IsMapped());
+    EXPECT_TRUE(from_cache.AlreadyLoaded());
+    ASSERT_EQ(from_cache.GetEvaluationEnergies().size(),
+              from_hdf5.GetEvaluationEnergies().size());
+    EXPECT_EQ(from_cache.GetThresholdIndex(MT::INELASTIC),
+              from_hdf5.GetThresholdIndex(MT::INELASTIC));
+
+    // mapped records stay cache line aligned
+    auto address = reinterpret_cast<std::uintptr_t>(from_cache.GetXSRecord(0));
+    EXPECT_EQ(address % CACHE_LINE_BYTES, 0);
+
+    for (double energy = -0.5; energy <= 3.0; energy += 0.125) {
+      size_t bin = from_cache.GetLowerEnergyBin(energy);
+      EXPECT_EQ(bin, from_hdf5.GetLowerEnergyBin(energy));
+      EXPECT_DOUBLE_EQ(from_cache.GetTotalXS(bin, energy),
+                       from_hdf5.GetTotalXS(bin, energy));
+      EXPECT_DOUBLE_EQ(from_cache.GetXSFromMT(MT::INELASTIC, bin, energy),
+                       from_hdf5.GetXSFromMT(MT::INELASTIC, bin, energy));
+    }
+  }
+}
+
+TEST_F(MaterialsXSCache, LoadFromFileUsesCache) {
+  WriteCache(nuclide_);
+
+  SetCacheEnv(cache_dir_.string());
+  ASSERT_TRUE(XSCache::ResolveCachePath(nuclide_, "294K").has_value());
+  EXPECT_FALSE(XSCache::ResolveCachePath("FakeO16", "294K").has_value());
+
+  Nuclide cached(nuclide_);
+  cached.LoadFromFile();
+  EXPECT_TRUE(cached.IsMapped());
+
+  // no cache file, falls back to hdf5
+  Nuclide uncached("FakeO16");
+  uncached.LoadFromFile();
+  EXPECT_FALSE(uncached.IsMapped());
+
+  UnsetCacheEnv();
+  EXPECT_FALSE(XSCache::ResolveCachePath(nuclide_, "294K").has_value());
+}
+
+TEST_F(MaterialsXSCache, RejectsBadFiles) {
+  std::string path = WriteCache(nuclide_);
+
+  // wrong nuclide
+  Nuclide other("FakeO16");
+  EXPECT_THROW(other.LoadFromXSCache(path), std::runtime_error);
+
+  // missing file
+  Nuclide nuc(nuclide_);
+  EXPECT_THROW(nuc.LoadFromXSCache((cache_dir_ / "missing.cxs").string()),
+               std::runtime_error);
+
+  // not a cache at all
+  std::string hdf5_path = (std::filesystem::path(test_xs_dir_) /
+                           (nuclide_ + ".h5")).string();
+  EXPECT_THROW(nuc.LoadFromXSCache(hdf5_path), std::runtime_error);
+
+  // stale version
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    uint32_t version = XS_CACHE_VERSION + 1;
+    file.seekp(offsetof(XSCacheHeader, version));
+    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+  }
+  EXPECT_THROW(nuc.LoadFromXSCache(path), std::runtime_error);
+
+  // truncated
+  path = WriteCache(nuclide_);
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+  EXPECT_THROW(nuc.LoadFromXSCache(path), std::runtime_error);
+  EXPECT_FALSE(nuc.AlreadyLoaded());
+
+  // nothing to cache yet
+  EXPECT_THROW(nuc.WriteXSCache(path), std::runtime_error);
+}
+
+}  // namespace charmander
@@ -189,6 +189,67 @@ TEST_F(MaterialsXSFileInterface, LeftPadLoad1DXSDataset) {
                std::runtime_error);
 }
 
+TEST_F(MaterialsXSFileInterface, StridedLoad1DXSDataset) {
+  std::vector<double> energies;
+  ASSERT_NO_THROW(interface_->LoadEvaluationEnergies("294K", energies));
+  std::vector<float> xs_real;
+  ASSERT_NO_THROW(
+      interface_->Load1DXSDataset("002", "294K", xs_real, energies.size()));
+
+  // every third float, the gaps must be left alone
+  const size_t stride = 3;
+  std::vector<float> strided(energies.size() * stride, -1.0f);
+  ASSERT_NO_THROW(interface_->Load1DXSDataset("002", "294K", strided.data(),
+                                              stride, energies.size()));
+  for (size_t i = 0; i < energies.size(); i++) {
+    ASSERT_DOUBLE_EQ(strided.at(i * stride), xs_real.at(i));
+    ASSERT_DOUBLE_EQ(strided.at(i * stride + 1), -1.0f);
+  }
+
+  // wrong target size
+  EXPECT_THROW(interface_->Load1DXSDataset("002", "294K", strided.data(),
+                                           stride, energies.size() + 1),
+               std::runtime_error);
+  // invalid formatted dataset (char instead of float in this case)
+  XSFileInterface bad_file("BadFakeU235");
+  EXPECT_THROW(bad_file.Load1DXSDataset("002", "294K", strided.data(), stride,
+                                        energies.size()),
+               std::runtime_error);
+}
+
+TEST_F(MaterialsXSFileInterface, LoadThreshold1DXSDataset) {
+  std::vector<double> energies;
+  ASSERT_NO_THROW(interface_->LoadEvaluationEnergies("294K", energies));
+  std::vector<float> xs_real;
+  ASSERT_NO_THROW(
+      interface_->Load1DXSDataset("002", "294K", xs_real, energies.size()));
+
+  // pretend the grid is two points longer, the data starts at index 2
+  const size_t stride = 2;
+  const size_t target_size = energies.size() + 2;
+  std::vector<float> strided(target_size * stride, -1.0f);
+  size_t threshold_index;
+  ASSERT_NO_THROW(threshold_index = interface_->LoadThreshold1DXSDataset(
+                      "002", "294K", strided.data(), stride, target_size));
+  EXPECT_EQ(threshold_index, 2);
+  // nothing below the threshold is touched
+  EXPECT_DOUBLE_EQ(strided.at(0), -1.0f);
+  EXPECT_DOUBLE_EQ(strided.at(stride), -1.0f);
+  for (size_t i = 0; i < xs_real.size(); i++) {
+    ASSERT_DOUBLE_EQ(strided.at((i + threshold_index) * stride),
+                     xs_real.at(i));
+  }
+
+  // dataset longer than the grid
+  EXPECT_THROW(interface_->LoadThreshold1DXSDataset(
+                   "002", "294K", strided.data(), stride, energies.size() - 1),
+               std::runtime_error);
+  // invalid dataset path
+  EXPECT_THROW(interface_->LoadThreshold1DXSDataset(
+                   "not", "real", strided.data(), stride, target_size),
+               std::runtime_error);
+}
+
 TEST_F(MaterialsXSFileInterface, Get1DXSDataPath) {
   std::string expected = "/FakeU235/reactions/reaction_002/294K/xs";
   EXPECT_EQ(expected, interface_->Get1DXSDataPath("002", "294K"));
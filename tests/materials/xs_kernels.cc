@@ -0,0 +1,66 @@
+#include "materials/xs_kernels.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "aligned_allocator.h"
+#include "materials/nuclide.h"
+
+namespace charmander {
+
+// grid of n points with a distinct, non-linear xs column
+class MaterialsXSKernels : public ::testing::Test {
+ protected:
+  static constexpr size_t n_points_ = 40;
+  static constexpr size_t n_lookups_ = 37;  // not a multiple of any SIMD width
+  std::vector<double> grid_;
+  std::vector<double> table_;
+  AlignedVector<float> records_;
+  std::vector<size_t> bins_;
+  std::vector<double> energies_;
+
+  void SetUp() override {
+    records_.assign(n_points_ * XS_RECORD_STRIDE, -1.0f);
+    for (size_t j = 0; j < n_points_; ++j) {
+      grid_.push_back(0.5 * j * j);
+      table_.push_back(1.0 + 0.25 * j * j * j);
+      records_[j * XS_RECORD_STRIDE + FISSION_CHANNEL] =
+          static_cast<float>(table_.back());
+    }
+    for (size_t i = 0; i < n_lookups_; ++i) {
+      const size_t bin = (7 * i) % (n_points_ - 1);
+      bins_.push_back(bin);
+      energies_.push_back(grid_[bin] + (grid_[bin + 1] - grid_[bin]) *
+                                           (i % 5) / 4.0);
+    }
+  }
+
+  double Expected(size_t i) const {
+    const size_t bin = bins_[i];
+    return table_[bin] + (table_[bin + 1] - table_[bin]) *
+                             (energies_[i] - grid_[bin]) /
+                             (grid_[bin + 1] - grid_[bin]);
+  }
+};
+
+TEST_F(MaterialsXSKernels, InterpolateRecordColumn) {
+  std::vector<double> xs(n_lookups_);
+  InterpolateRecordColumn(grid_.data(), records_.data() + FISSION_CHANNEL,
+                          bins_.data(), energies_.data(), xs.data(),
+                          n_lookups_);
+  for (size_t i = 0; i < n_lookups_; ++i) {
+    EXPECT_DOUBLE_EQ(xs[i], Expected(i)) << "lookup " << i;
+  }
+}
+
+TEST_F(MaterialsXSKernels, InterpolateTable) {
+  std::vector<double> xs(n_lookups_);
+  InterpolateTable(grid_.data(), table_.data(), bins_.data(), energies_.data(),
+                   xs.data(), n_lookups_);
+  for (size_t i = 0; i < n_lookups_; ++i) {
+    EXPECT_DOUBLE_EQ(xs[i], Expected(i)) << "lookup " << i;
+  }
+}
+
+}  // namespace charmander
@@ -0,0 +1,203 @@
+#include "transport/event_driver.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "basic_types.h"
+#include "env_wrapper.h"
+#include "geometry/cylinder.h"
+#include "geometry/geometry.h"
+#include "geometry/lattice.h"
+#include "geometry/plane.h"
+#include "geometry/region.h"
+#include "materials/ce_material.h"
+#include "materials/nuclide.h"
+#include "transport/history_driver.h"
+#include "transport/transport.h"
+
+namespace charmander {
+
+// a 3 x 3 lattice of fuel pins in moderator, everything outside leaks
+class TransportEventDriver : public test_helpers::CharmanderXSEnvWrapper,
+                             public ::testing::Test {
+ protected:
+  ZCylinder pin_{0.4, {0.0, 0.0, 0.0}};
+  XPlane left_{-1.5};
+  XPlane right_{1.5};
+  YPlane back_{-1.5};
+  YPlane front_{1.5};
+  ZPlane bottom_{-2.0};
+  ZPlane top_{2.0};
+  Geometry geometry_;
+  std::shared_ptr<CEMaterial> fuel_;
+  std::shared_ptr<CEMaterial> moderator_;
+
+  void SetUp() override {
+    overwrite();
+    auto u235 = std::make_shared<Nuclide>(nuclide_);
+    u235->LoadFromFile();
+    auto o16 = std::make_shared<Nuclide>("FakeO16");
+    o16->LoadFromFile();
+    fuel_ =
+        std::make_shared<CEMaterial>(1, std::vector<NuclideData>{{u235, 1.0}});
+    moderator_ =
+        std::make_shared<CEMaterial>(2, std::vector<NuclideData>{{o16, 1.0}});
+
+    const uint32_t pin_universe = geometry_.AddUniverse();
+    geometry_.AddCell(pin_universe, Region({{-pin_}}), 1);
+    geometry_.AddCell(pin_universe, Region({{+pin_}}), 2);
+    const uint32_t lattice = geometry_.AddLattice(Lattice::Rectangular(
+        -1.5, -1.5, 1.0, 1.0, 3, 3, std::vector<uint32_t>(9, pin_universe)));
+    geometry_.AddFilledCell(
+        Geometry::ROOT_UNIVERSE,
+        Region({{+left_, -right_, +back_, -front_, +bottom_, -top_}}),
+        FillType::LATTICE, lattice);
+    geometry_.Finalize();
+  }
+
+  void TearDown() override { reinstate(); }
+
+  TransportProblem MakeProblem() const {
+    TransportProblem problem(geometry_, IsotropicPointSource({}, 1.5));
+    problem.SetMaterial(1, fuel_, 0.05);
+    problem.SetMaterial(2, moderator_, 0.1);
+    return problem;
+  }
+};
+
+TEST_F(TransportEventDriver, MatchesHistoryDriver) {
+  TransportProblem problem = MakeProblem();
+  const uint64_t n = 1500;
+  const TransportTally history = HistoryDriver(problem).Run(n, 11, 1);
+  // a batch size that does not divide n leaves a short last batch
+  const TransportTally event = EventDriver(problem, 256).Run(n, 11, 2);
+
+  EXPECT_EQ(event.histories, n);
+  EXPECT_EQ(event.lost, 0);
+  EXPECT_EQ(event.captures + event.fissions + event.leaks, n);
+  EXPECT_GT(event.collisions, 0);
+  EXPECT_GT(event.crossings, 0);
+
+  // same random streams, same histories
+  EXPECT_EQ(event.collisions, history.collisions);
+  EXPECT_EQ(event.crossings, history.crossings);
+  EXPECT_EQ(event.captures, history.captures);
+  EXPECT_EQ(event.fissions, history.fissions);
+  EXPECT_EQ(event.leaks, history.leaks);
+  ASSERT_EQ(event.flux.size(), history.flux.size());
+  for (size_t i = 0; i < event.flux.size(); ++i) {
+    EXPECT_NEAR(event.flux[i], history.flux[i], 1e-9 * (1.0 + history.flux[i]));
+  }
+}
+
+TEST_F(TransportEventDriver, DeltaTrackingMatchesHistoryDriver) {
+  TransportProblem problem = MakeProblem();
+  problem.SetTracking(TrackingMode::DELTA);
+  problem.BuildMajorant();
+
+  auto expect_same_histories = [&] {
+    const uint64_t n = 1000;
+    const TransportTally history = HistoryDriver(problem).Run(n, 13, 1);
+    const TransportTally event = EventDriver(problem, 300).Run(n, 13, 2);
+
+    EXPECT_EQ(event.lost, 0);
+    EXPECT_EQ(event.captures + event.fissions + event.leaks, n);
+    EXPECT_GT(event.virtual_collisions, 0);
+    EXPECT_EQ(event.collisions, history.collisions);
+    EXPECT_EQ(event.virtual_collisions, history.virtual_collisions);
+    EXPECT_EQ(event.crossings, history.crossings);
+    EXPECT_EQ(event.captures, history.captures);
+    EXPECT_EQ(event.leaks, history.leaks);
+    for (size_t i = 0; i < event.flux.size(); ++i) {
+      EXPECT_NEAR(event.flux[i], history.flux[i],
+                  1e-9 * (1.0 + history.flux[i]));
+    }
+  };
+  expect_same_histories();
+
+  // mixed, the pins are surface tracked and the moderator delta tracked
+  problem.SetCellTracking(0, TrackingMode::SURFACE);
+  expect_same_histories();
+}
+
+TEST_F(TransportEventDriver, EventLimitMatchesHistoryDriver) {
+  TransportProblem problem = MakeProblem();
+  problem.BuildMajorant();
+  // few enough flights that many histories stop at the limit
+  problem.SetMaxEvents(4);
+
+  auto expect_same_limit = [&] {
+    const uint64_t n = 1000;
+    const TransportTally history = HistoryDriver(problem).Run(n, 17, 1);
+    const TransportTally event = EventDriver(problem, 200).Run(n, 17, 2);
+
+    EXPECT_GT(event.lost, 0);
+    EXPECT_LT(event.lost, n);
+    EXPECT_EQ(event.lost, history.lost);
+    EXPECT_EQ(event.collisions, history.collisions);
+    EXPECT_EQ(event.virtual_collisions, history.virtual_collisions);
+    EXPECT_EQ(event.crossings, history.crossings);
+    EXPECT_EQ(event.captures, history.captures);
+    EXPECT_EQ(event.fissions, history.fissions);
+    EXPECT_EQ(event.leaks, history.leaks);
+    for (size_t i = 0; i < event.flux.size(); ++i) {
+      EXPECT_NEAR(event.flux[i], history.flux[i],
+                  1e-9 * (1.0 + history.flux[i]));
+    }
+  };
+  expect_same_limit();
+
+  // virtual collisions count as events in both drivers
+  problem.SetTracking(TrackingMode::DELTA);
+  expect_same_limit();
+  problem.SetCellTracking(0, TrackingMode::SURFACE);
+  expect_same_limit();
+}
+
+TEST_F(TransportEventDriver, BatchSizeInvariant) {
+  TransportProblem problem = MakeProblem();
+  const TransportTally one = EventDriver(problem, 1).Run(200, 3, 1);
+  const TransportTally all = EventDriver(problem, 200).Run(200, 3, 1);
+  EXPECT_EQ(one.collisions, all.collisions);
+  EXPECT_EQ(one.crossings, all.crossings);
+  EXPECT_EQ(one.leaks, all.leaks);
+}
+
+TEST_F(TransportEventDriver, ThreadCountInvariant) {
+  TransportProblem problem = MakeProblem();
+  EventDriver driver(problem, 128);
+
+  // batches are summed in order, so the flux is bitwise the same on any
+  // number of threads and on every run
+  const TransportTally serial = driver.Run(1000, 5, 1);
+  for (size_t n_threads : {2, 4, 4}) {
+    const TransportTally threaded = driver.Run(1000, 5, n_threads);
+    EXPECT_EQ(serial.collisions, threaded.collisions);
+    EXPECT_EQ(serial.crossings, threaded.crossings);
+    EXPECT_EQ(serial.leaks, threaded.leaks);
+    ASSERT_EQ(serial.flux.size(), threaded.flux.size());
+    for (size_t i = 0; i < serial.flux.size(); ++i) {
+      EXPECT_EQ(serial.flux[i], threaded.flux[i]) << n_threads;
+    }
+  }
+}
+
+TEST_F(TransportEventDriver, Validation) {
+  TransportProblem problem = MakeProblem();
+  EXPECT_THROW(EventDriver(problem, 0), std::runtime_error);
+
+  TransportProblem missing(geometry_, IsotropicPointSource({}, 1.5));
+  EXPECT_THROW(EventDriver(missing).Run(10), std::runtime_error);
+
+  // sources outside the geometry are lost
+  TransportProblem outside(geometry_,
+                           IsotropicPointSource({5.0, 0.0, 0.0}, 1.5));
+  outside.SetMaterial(1, fuel_, 0.05);
+  outside.SetMaterial(2, moderator_, 0.1);
+  EXPECT_EQ(EventDriver(outside).Run(10, 1, 1).lost, 10);
+}
+
+}  // namespace charmander
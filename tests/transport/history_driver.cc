@@ -0,0 +1,167 @@
+#include "transport/history_driver.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+
+#include "basic_types.h"
+#include "constants.h"
+#include "env_wrapper.h"
+#include "geometry/cylinder.h"
+#include "geometry/geometry.h"
+#include "geometry/plane.h"
+#include "geometry/region.h"
+#include "materials/ce_material.h"
+#include "materials/nuclide.h"
+#include "transport/transport.h"
+
+namespace charmander {
+
+// a fuel pin in a box of moderator, everything outside the box leaks
+class TransportHistoryDriver : public test_helpers::CharmanderXSEnvWrapper,
+                               public ::testing::Test {
+ protected:
+  ZCylinder pin_{1.0, {0.0, 0.0, 0.0}};
+  XPlane left_{-2.0};
+  XPlane right_{2.0};
+  YPlane back_{-2.0};
+  YPlane front_{2.0};
+  ZPlane bottom_{-2.0};
+  ZPlane top_{2.0};
+  Geometry geometry_;
+  std::shared_ptr<CEMaterial> fuel_;
+  std::shared_ptr<CEMaterial> moderator_;
+
+  void SetUp() override {
+    overwrite();
+    auto u235 = std::make_shared<Nuclide>(nuclide_);
+    u235->LoadFromFile();
+    auto o16 = std::make_shared<Nuclide>("FakeO16");
+    o16->LoadFromFile();
+    fuel_ =
+        std::make_shared<CEMaterial>(1, std::vector<NuclideData>{{u235, 1.0}});
+    moderator_ =
+        std::make_shared<CEMaterial>(2, std::vector<NuclideData>{{o16, 1.0}});
+
+    geometry_.AddCell(Region({{-pin_, +bottom_, -top_}}), 1);
+    geometry_.AddCell(Region({{+pin_, +left_, -right_, +back_, -front_,
+                               +bottom_, -top_}}),
+                      2);
+    geometry_.Finalize();
+  }
+
+  void TearDown() override { reinstate(); }
+};
+
+TEST_F(TransportHistoryDriver, Run) {
+  TransportProblem problem(geometry_, IsotropicPointSource({}, 1.5));
+  problem.SetMaterial(1, fuel_, 0.05);
+  problem.SetMaterial(2, moderator_, 0.05);
+  HistoryDriver driver(problem);
+
+  const uint64_t n = 1000;
+  const TransportTally tally = driver.Run(n, 42, 1);
+  EXPECT_EQ(tally.histories, n);
+  EXPECT_EQ(tally.lost, 0);
+  EXPECT_EQ(tally.captures + tally.fissions + tally.leaks, n);
+  EXPECT_GT(tally.collisions, 0);
+  EXPECT_GT(tally.crossings, 0);
+  EXPECT_GT(tally.leaks, 0);
+  EXPECT_GT(tally.flux[0], 0.0);
+  EXPECT_GT(tally.flux[1], 0.0);
+}
+
+TEST_F(TransportHistoryDriver, ThreadCountInvariant) {
+  TransportProblem problem(geometry_, IsotropicPointSource({}, 1.5));
+  problem.SetMaterial(1, fuel_, 0.05);
+  problem.SetMaterial(2, moderator_, 0.05);
+  HistoryDriver driver(problem);
+
+  // every history has its own stream and chunks are summed in order, so
+  // the threads change nothing, not even the flux rounding
+  const TransportTally serial = driver.Run(2000, 7, 1);
+  const TransportTally threaded = driver.Run(2000, 7, 4);
+  EXPECT_EQ(serial.histories, threaded.histories);
+  EXPECT_EQ(serial.collisions, threaded.collisions);
+  EXPECT_EQ(serial.crossings, threaded.crossings);
+  EXPECT_EQ(serial.captures, threaded.captures);
+  EXPECT_EQ(serial.fissions, threaded.fissions);
+  EXPECT_EQ(serial.leaks, threaded.leaks);
+  for (size_t i = 0; i < serial.flux.size(); ++i) {
+    EXPECT_EQ(serial.flux[i], threaded.flux[i]);
+  }
+
+  const TransportTally other_seed = driver.Run(2000, 8, 4);
+  EXPECT_NE(serial.collisions, other_seed.collisions);
+}
+
+TEST_F(TransportHistoryDriver, Void) {
+  // with nothing to collide with every particle streams out of the pin,
+  // its track length is the chord out of the cell
+  Geometry empty;
+  empty.AddCell(Region({{-pin_, +bottom_, -top_}}), -1);
+  empty.Finalize();
+  TransportProblem void_problem(empty, IsotropicPointSource({}, 1.5));
+  const TransportTally tally = HistoryDriver(void_problem).Run(100, 1, 2);
+  EXPECT_EQ(tally.leaks, 100);
+  EXPECT_EQ(tally.collisions, 0);
+  EXPECT_EQ(tally.crossings, 100);
+  // every chord is between the pin radius and the corner of the pin cell
+  EXPECT_GE(tally.flux[0], 100 * 1.0);
+  EXPECT_LE(tally.flux[0], 100 * std::sqrt(5.0));
+}
+
+TEST_F(TransportHistoryDriver, Lost) {
+  // a source outside the geometry is lost, not leaked
+  TransportProblem problem(geometry_,
+                           IsotropicPointSource({5.0, 0.0, 0.0}, 1.5));
+  problem.SetMaterial(1, fuel_, 0.05);
+  problem.SetMaterial(2, moderator_, 0.05);
+  const TransportTally tally = HistoryDriver(problem).Run(10, 1, 1);
+  EXPECT_EQ(tally.lost, 10);
+
+  TransportProblem missing(geometry_, IsotropicPointSource({}, 1.5));
+  missing.SetMaterial(1, fuel_, 0.05);
+  EXPECT_THROW(HistoryDriver(missing).Run(10), std::runtime_error);
+}
+
+TEST_F(TransportHistoryDriver, DeltaTracking) {
+  TransportProblem problem(geometry_, IsotropicPointSource({}, 1.5));
+  problem.SetMaterial(1, fuel_, 0.05);
+  problem.SetMaterial(2, moderator_, 0.05);
+  const uint64_t n = 4000;
+  const TransportTally surface = HistoryDriver(problem).Run(n, 5, 1);
+
+  // delta tracking needs a majorant built after the last material
+  problem.SetTracking(TrackingMode::DELTA);
+  EXPECT_THROW(HistoryDriver(problem).Run(n), std::runtime_error);
+  problem.BuildMajorant();
+  const TransportTally delta = HistoryDriver(problem).Run(n, 5, 1);
+
+  // mixed, the pin is surface tracked and the moderator delta tracked
+  problem.SetCellTracking(0, TrackingMode::SURFACE);
+  const TransportTally mixed = HistoryDriver(problem).Run(n, 5, 1);
+
+  EXPECT_EQ(delta.crossings, 0);
+  EXPECT_GT(delta.virtual_collisions, 0);
+  EXPECT_GT(mixed.crossings, 0);
+  EXPECT_GT(mixed.virtual_collisions, 0);
+  EXPECT_EQ(surface.virtual_collisions, 0);
+
+  // all three sample the same physics
+  for (const TransportTally* tally : {&delta, &mixed}) {
+    EXPECT_EQ(tally->lost, 0);
+    EXPECT_EQ(tally->captures + tally->fissions + tally->leaks, n);
+    EXPECT_NEAR(tally->leaks, surface.leaks, 4 * std::sqrt(n));
+    EXPECT_NEAR(tally->captures, surface.captures, 4 * std::sqrt(n));
+    EXPECT_NEAR(tally->collisions, surface.collisions,
+                0.05 * surface.collisions);
+    for (size_t i = 0; i < surface.flux.size(); ++i) {
+      EXPECT_NEAR(tally->flux[i], surface.flux[i], 0.05 * surface.flux[i]);
+    }
+  }
+}
+
+}  // namespace charmander
@@ -0,0 +1,83 @@
+#include "transport/particle_bank.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "basic_types.h"
+#include "constants.h"
+
+namespace charmander {
+
+TEST(ParticleBank, AddAndAccess) {
+  ParticleBank bank(4);
+  EXPECT_TRUE(bank.Empty());
+
+  const size_t i = bank.Add(Vec3(Point(1.0, 2.0, 3.0)),
+                            Vec3(Direction(0.0, 0.0, 1.0)), 2.0e6);
+  const size_t j = bank.Add(Vec3(-1.0, 0.0, 0.0), Vec3(1.0, 0.0, 0.0), 1.0,
+                            0.5, 7);
+  EXPECT_EQ(i, 0);
+  EXPECT_EQ(j, 1);
+  EXPECT_EQ(bank.Size(), 2);
+
+  EXPECT_EQ(bank.GetPosition(0), Vec3(1.0, 2.0, 3.0));
+  EXPECT_EQ(bank.GetDirection(0).ToDirection(), Direction(0.0, 0.0, 1.0));
+  EXPECT_DOUBLE_EQ(bank.E[0], 2.0e6);
+  EXPECT_DOUBLE_EQ(bank.weight[0], 1.0);
+  EXPECT_EQ(bank.cell[0], ParticleBank::NO_CELL);
+  EXPECT_DOUBLE_EQ(bank.weight[1], 0.5);
+  EXPECT_EQ(bank.cell[1], 7);
+
+  bank.SetPosition(1, {4.0, 5.0, 6.0});
+  bank.SetDirection(1, {0.0, -1.0, 0.0});
+  EXPECT_EQ(bank.GetPosition(1).ToPoint(), Point(4.0, 5.0, 6.0));
+  EXPECT_EQ(bank.GetDirection(1), Vec3(0.0, -1.0, 0.0));
+
+  bank.Swap(0, 1);
+  EXPECT_EQ(bank.GetPosition(0), Vec3(4.0, 5.0, 6.0));
+  EXPECT_EQ(bank.cell[0], 7);
+  EXPECT_DOUBLE_EQ(bank.E[1], 2.0e6);
+}
+
+TEST(ParticleBank, Alignment) {
+  ParticleBank bank;
+  bank.Resize(37);
+  EXPECT_EQ(bank.Size(), 37);
+  EXPECT_EQ(bank.cell[36], ParticleBank::NO_CELL);
+  for (const double* data : {bank.x.data(), bank.y.data(), bank.z.data(),
+                             bank.u.data(), bank.v.data(), bank.w.data(),
+                             bank.E.data(), bank.weight.data()}) {
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(data) % CACHE_LINE_BYTES, 0);
+  }
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(bank.cell.data()) % CACHE_LINE_BYTES,
+            0);
+
+  bank.Clear();
+  EXPECT_TRUE(bank.Empty());
+}
+
+TEST(ParticleBank, Advance) {
+  ParticleBank bank;
+  const size_t n = 19;
+  std::vector<double> distances(n);
+  for (size_t i = 0; i < n; ++i) {
+    bank.Add(Vec3(i, 0.0, 0.0), Vec3(normalize(Direction(1.0, 1.0, 0.0))),
+             1.0);
+    distances[i] = static_cast<double>(i);
+  }
+  bank.Advance(distances);
+  for (size_t i = 0; i < n; ++i) {
+    EXPECT_DOUBLE_EQ(bank.x[i], i + i / std::sqrt(2.0));
+    EXPECT_DOUBLE_EQ(bank.y[i], i / std::sqrt(2.0));
+    EXPECT_DOUBLE_EQ(bank.z[i], 0.0);
+  }
+
+  distances.pop_back();
+  EXPECT_THROW(bank.Advance(distances), std::runtime_error);
+}
+
+}  // namespace charmander
@@ -0,0 +1,116 @@
+#include "transport/philox.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace charmander {
+
+TEST(Philox, KnownAnswers) {
+  // Random123 known answer vectors for philox4x32_10
+  EXPECT_EQ(Philox4x32({0, 0, 0, 0}, {0, 0}),
+            (PhiloxCounter{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+  EXPECT_EQ(Philox4x32({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                       {0xffffffff, 0xffffffff}),
+            (PhiloxCounter{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+  EXPECT_EQ(Philox4x32({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                       {0xa4093822, 0x299f31d0}),
+            (PhiloxCounter{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+}
+
+TEST(Philox, Stream) {
+  PhiloxStream stream(3, 5);
+  std::vector<uint64_t> draws;
+  for (int i = 0; i < 9; ++i) draws.push_back(stream());
+  EXPECT_EQ(stream.GetPosition(), 9);
+  for (uint64_t i = 0; i < draws.size(); ++i) {
+    EXPECT_EQ(draws[i], PhiloxStream::Draw(3, 5, i));
+  }
+
+  // skipping lands on the same draws in O(1)
+  PhiloxStream skipped(3, 5);
+  skipped.Skip(7);
+  EXPECT_EQ(skipped(), draws[7]);
+  EXPECT_EQ(skipped(), draws[8]);
+
+  // other batches and particles are other streams
+  EXPECT_NE(PhiloxStream(3, 6)(), draws[0]);
+  EXPECT_NE(PhiloxStream(4, 5)(), draws[0]);
+}
+
+TEST(Philox, Uniform) {
+  EXPECT_EQ(ToUniform(0), 0.0);
+  EXPECT_LT(ToUniform(~uint64_t{0}), 1.0);
+
+  PhiloxStream stream(1, 1);
+  double sum = 0.0;
+  const int n = 100000;
+  for (int i = 0; i < n; ++i) {
+    const double u = stream.Uniform();
+    EXPECT_GE(u, 0.0);
+    EXPECT_LT(u, 1.0);
+    sum += u;
+  }
+  EXPECT_NEAR(sum / n, 0.5, 0.005);
+}
+
+TEST(Philox, FillUniforms) {
+  // odd starts and lengths that are not a multiple of the lanes
+  for (uint64_t first : {0, 1, 6, 17}) {
+    std::vector<double> out(37);
+    FillUniforms(9, 2, first, out);
+    PhiloxStream stream(9, 2);
+    stream.Skip(first);
+    for (double u : out) EXPECT_EQ(u, stream.Uniform());
+  }
+}
+
+TEST(Philox, NextUniforms) {
+  std::vector<PhiloxStream> streams;
+  std::vector<PhiloxStream> reference;
+  for (uint64_t particle = 0; particle < 21; ++particle) {
+    streams.emplace_back(4, particle);
+    reference.emplace_back(4, particle);
+    // streams at different positions
+    streams.back().Skip(particle % 3);
+    reference.back().Skip(particle % 3);
+  }
+
+  const std::vector<uint32_t> indices = {20, 3, 4, 0, 7, 11, 12, 13, 2, 19, 5};
+  std::vector<double> out(indices.size());
+  for (int pass = 0; pass < 3; ++pass) {
+    NextUniforms(streams, indices, out);
+    for (size_t j = 0; j < indices.size(); ++j) {
+      EXPECT_EQ(out[j], reference[indices[j]].Uniform());
+    }
+  }
+  EXPECT_EQ(streams[1].GetPosition(), 1);
+  EXPECT_EQ(streams[20].GetPosition(), 2 + 3);
+
+  out.pop_back();
+  EXPECT_THROW(NextUniforms(streams, indices, out), std::runtime_error);
+}
+
+TEST(Philox, ThreadIndependent) {
+  // streams hold no shared state, each thread reproduces the serial draws
+  const int n_threads = 4;
+  std::vector<std::vector<double>> draws(n_threads, std::vector<double>(64));
+  std::vector<std::thread> threads;
+  for (int t = 0; t < n_threads; ++t) {
+    threads.emplace_back([&, t] {
+      PhiloxStream stream(1, t);
+      for (double& u : draws[t]) u = stream.Uniform();
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (int t = 0; t < n_threads; ++t) {
+    std::vector<double> serial(64);
+    FillUniforms(1, t, 0, serial);
+    EXPECT_EQ(draws[t], serial);
+  }
+}
+
+}  // namespace charmander
@@ -0,0 +1,259 @@
+#include "transport/transport.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "basic_types.h"
+#include "constants.h"
+#include "env_wrapper.h"
+#include "geometry/cylinder.h"
+#include "geometry/geometry.h"
+#include "geometry/region.h"
+#include "materials/ce_material.h"
+#include "materials/nuclide.h"
+
+namespace charmander {
+
+TEST(Transport, ParticleRNG) {
+  TransportRNG a = ParticleRNG(1, 7);
+  TransportRNG b = ParticleRNG(1, 7);
+  TransportRNG c = ParticleRNG(1, 8);
+  TransportRNG d = ParticleRNG(2, 7);
+  const auto first = a();
+  EXPECT_EQ(first, b());
+  EXPECT_NE(first, c());
+  EXPECT_NE(first, d());
+}
+
+TEST(Transport, SampleIsotropicDirection) {
+  TransportRNG rng = ParticleRNG(1, 0);
+  Vec3 mean;
+  const int n = 20000;
+  for (int i = 0; i < n; ++i) {
+    const Vec3 d = SampleIsotropicDirection(rng);
+    EXPECT_NEAR(dot(d, d), 1.0, 1e-12);
+    mean += d;
+  }
+  mean *= 1.0 / n;
+  EXPECT_NEAR(mean.x, 0.0, 0.02);
+  EXPECT_NEAR(mean.y, 0.0, 0.02);
+  EXPECT_NEAR(mean.z, 0.0, 0.02);
+}
+
+TEST(Transport, SampleCollisionDistance) {
+  TransportRNG rng = ParticleRNG(1, 0);
+  EXPECT_EQ(SampleCollisionDistance(0.0, rng), INF);
+
+  // mean free path is 1 / total
+  double sum = 0.0;
+  const int n = 20000;
+  for (int i = 0; i < n; ++i) sum += SampleCollisionDistance(2.0, rng);
+  EXPECT_NEAR(sum / n, 0.5, 0.02);
+}
+
+TEST(Transport, SampleCollision) {
+  TransportRNG rng = ParticleRNG(1, 0);
+  ReactionXS xs;
+  xs.xs[ELASTIC_CHANNEL] = 1.0;
+  xs.xs[INELASTIC_CHANNEL] = 1.0;
+  xs.xs[CAPTURE_CHANNEL] = 1.0;
+  xs.xs[FISSION_CHANNEL] = 1.0;
+  int counts[3] = {0, 0, 0};
+  const int n = 20000;
+  for (int i = 0; i < n; ++i) {
+    ++counts[static_cast<int>(SampleCollision(xs, rng))];
+  }
+  EXPECT_NEAR(counts[0] / static_cast<double>(n), 0.5, 0.02);
+  EXPECT_NEAR(counts[1] / static_cast<double>(n), 0.25, 0.02);
+  EXPECT_NEAR(counts[2] / static_cast<double>(n), 0.25, 0.02);
+}
+
+TEST(Transport, TallyMerge) {
+  TransportTally a(2);
+  TransportTally b(3);
+  a.histories = 2;
+  a.flux[1] = 1.0;
+  b.histories = 3;
+  b.leaks = 1;
+  b.flux[1] = 0.5;
+  b.flux[2] = 4.0;
+  a.Merge(b);
+  EXPECT_EQ(a.histories, 5);
+  EXPECT_EQ(a.leaks, 1);
+  ASSERT_EQ(a.flux.size(), 3);
+  EXPECT_DOUBLE_EQ(a.flux[1], 1.5);
+  EXPECT_DOUBLE_EQ(a.flux[2], 4.0);
+
+  a.Clear();
+  EXPECT_EQ(a.histories, 0);
+  EXPECT_EQ(a.leaks, 0);
+  ASSERT_EQ(a.flux.size(), 3);
+  EXPECT_EQ(a.flux[1], 0.0);
+}
+
+TEST(Transport, OrderedTallyReduction) {
+  // items finish out of order on several threads, the sum is still in item
+  // order and never holds more than the window of tallies
+  const uint64_t n_items = 2000;
+  const size_t n_cells = 1000;
+  const size_t n_threads = 4;
+  auto fill = [&](uint64_t item, TransportTally& tally) {
+    ++tally.histories;
+    for (size_t c = 0; c < n_cells; ++c) {
+      tally.flux[c] += 1.0 / static_cast<double>(item * n_cells + c + 1);
+    }
+  };
+
+  TransportTally expected(n_cells);
+  for (uint64_t item = 0; item < n_items; ++item) {
+    TransportTally tally(n_cells);
+    fill(item, tally);
+    expected.Merge(tally);
+  }
+
+  OrderedTallyReduction reduction(
+      n_items, n_cells, OrderedTallyReduction::WINDOW_PER_THREAD * n_threads);
+  auto worker = [&] {
+    uint64_t item;
+    TransportTally* tally;
+    while (reduction.Next(item, tally)) {
+      EXPECT_EQ(tally->histories, 0);
+      fill(item, *tally);
+      // every seventh item runs long so later ones finish first
+      if (item % 7 == 0) std::this_thread::yield();
+      reduction.Finish(item);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < n_threads; ++t) workers.emplace_back(worker);
+  for (auto& thread : workers) thread.join();
+
+  EXPECT_GT(reduction.GetPeakPending(), 0);
+  EXPECT_LE(reduction.GetPeakPending(), reduction.GetWindow());
+  EXPECT_EQ(reduction.GetWindow(),
+            OrderedTallyReduction::WINDOW_PER_THREAD * n_threads);
+  const TransportTally result = reduction.TakeResult();
+  EXPECT_EQ(result.histories, n_items);
+  ASSERT_EQ(result.flux.size(), n_cells);
+  for (size_t c = 0; c < n_cells; ++c) {
+    EXPECT_EQ(result.flux[c], expected.flux[c]);
+  }
+
+  // a failed worker stops the others claiming items
+  OrderedTallyReduction aborted(n_items, n_cells, 2);
+  uint64_t item;
+  TransportTally* tally;
+  ASSERT_TRUE(aborted.Next(item, tally));
+  aborted.Abort();
+  EXPECT_FALSE(aborted.Next(item, tally));
+}
+
+TEST(Transport, ProblemValidation) {
+  ZCylinder pin(1.0, {0.0, 0.0, 0.0});
+  Geometry geometry;
+  geometry.AddCell(Region({{-pin}}), 3);
+  geometry.AddCell(Region({{+pin}}), -1);
+
+  EXPECT_THROW(TransportProblem(geometry, nullptr), std::runtime_error);
+  TransportProblem problem(geometry, IsotropicPointSource({}, 1.0));
+  EXPECT_THROW(problem.Validate(), std::runtime_error);
+  geometry.Finalize();
+  // material 3 is undefined, the void cell needs nothing
+  EXPECT_THROW(problem.Validate(), std::runtime_error);
+  EXPECT_EQ(problem.GetMaterial(-1), nullptr);
+  EXPECT_EQ(problem.GetMaterial(3), nullptr);
+  EXPECT_THROW(problem.SetMaterial(-1, nullptr, 1.0), std::runtime_error);
+  EXPECT_THROW(problem.SetMaterial(3, nullptr, 1.0), std::runtime_error);
+
+  TransportRNG rng = ParticleRNG(1, 0);
+  const SourceSite site = problem.SampleSource(rng);
+  EXPECT_EQ(site.position, Vec3());
+  EXPECT_DOUBLE_EQ(site.energy, 1.0);
+}
+
+TEST(Transport, AcceptDeltaCollision) {
+  EXPECT_TRUE(AcceptDeltaCollision(1.0, 2.0, 0.49));
+  EXPECT_FALSE(AcceptDeltaCollision(1.0, 2.0, 0.5));
+  // void cells reject every collision
+  EXPECT_FALSE(AcceptDeltaCollision(0.0, 2.0, 0.0));
+  EXPECT_THROW(AcceptDeltaCollision(2.5, 2.0, 0.1), std::runtime_error);
+}
+
+class TransportMajorant : public test_helpers::CharmanderXSEnvWrapper,
+                          public ::testing::Test {
+ protected:
+  void SetUp() override { overwrite(); }
+  void TearDown() override { reinstate(); }
+};
+
+TEST_F(TransportMajorant, BoundsEveryMaterial) {
+  auto u235 = std::make_shared<Nuclide>(nuclide_);
+  u235->LoadFromFile();
+  auto o16 = std::make_shared<Nuclide>("FakeO16");
+  o16->LoadFromFile();
+  const std::vector<TransportMaterial> materials = {
+      {std::make_shared<CEMaterial>(1, std::vector<NuclideData>{{u235, 1.0}}),
+       0.05},
+      {},
+      {std::make_shared<CEMaterial>(
+           2, std::vector<NuclideData>{{o16, 0.5}, {u235, 0.5}}),
+       0.2},
+  };
+  const MajorantXS majorant(materials);
+  ASSERT_FALSE(majorant.Empty());
+  EXPECT_GE(majorant.GetEnergies().size(),
+            u235->GetEvaluationEnergies().size());
+
+  // tight at grid points, above every material in between and past the ends
+  for (double energy : majorant.GetEnergies()) {
+    const double max_xs = std::max(materials[0].GetTotalXS(energy),
+                                   materials[2].GetTotalXS(energy));
+    EXPECT_NEAR(majorant.GetXS(energy), max_xs, 1e-8 * max_xs);
+  }
+  for (double energy = -0.5; energy < 3.0; energy += 0.01) {
+    EXPECT_GE(majorant.GetXS(energy), materials[0].GetTotalXS(energy));
+    EXPECT_GE(majorant.GetXS(energy), materials[2].GetTotalXS(energy));
+  }
+
+  EXPECT_THROW(MajorantXS(std::vector<TransportMaterial>{}),
+               std::runtime_error);
+}
+
+TEST(Transport, ProblemTracking) {
+  ZCylinder pin(1.0, {0.0, 0.0, 0.0});
+  Geometry geometry;
+  geometry.AddCell(Region({{-pin}}), -1);
+  geometry.AddCell(Region({{+pin}}), -1);
+  geometry.Finalize();
+
+  TransportProblem problem(geometry, IsotropicPointSource({}, 1.0));
+  EXPECT_FALSE(problem.UsesDeltaTracking());
+  problem.SetCellTracking(1, TrackingMode::DELTA);
+  EXPECT_EQ(problem.GetTracking(0), TrackingMode::SURFACE);
+  EXPECT_EQ(problem.GetTracking(1), TrackingMode::DELTA);
+  EXPECT_TRUE(problem.UsesDeltaTracking());
+  EXPECT_THROW(problem.SetCellTracking(2, TrackingMode::DELTA),
+               std::runtime_error);
+  // no majorant yet
+  EXPECT_THROW(problem.Validate(), std::runtime_error);
+
+  problem.SetTracking(TrackingMode::SURFACE);
+  EXPECT_EQ(problem.GetTracking(1), TrackingMode::SURFACE);
+  EXPECT_NO_THROW(problem.Validate());
+
+  EXPECT_EQ(problem.GetMaxEvents(), TransportProblem::DEFAULT_MAX_EVENTS);
+  EXPECT_THROW(problem.SetMaxEvents(0), std::runtime_error);
+  problem.SetMaxEvents(2);
+  uint64_t events = 0;
+  EXPECT_TRUE(problem.CountEvent(events));
+  EXPECT_TRUE(problem.CountEvent(events));
+  EXPECT_FALSE(problem.CountEvent(events));
+}
+
+}  // namespace charmander